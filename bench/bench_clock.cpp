@@ -0,0 +1,70 @@
+/*
+ * Bench clock implementation
+ */
+
+ #include "bench_clock.h"
+
+ #if defined(__AVR__)
+
+ #include <avr/interrupt.h>
+
+ static volatile uint16_t timer1Overflows = 0;
+
+ /*
+  * Timer1 overflow extends the 16-bit counter to 32 bits
+  */
+ ISR(TIMER1_OVF_vect) {
+   timer1Overflows++;
+ }
+
+ /*
+  * Free-running Timer1 at F_CPU, normal mode, overflow interrupt only
+  * Replaces the firmware's 1-second CTC configuration for the bench build
+  */
+ void benchClockStart() {
+   cli();
+   TCCR1A = 0;
+   TCCR1B = 0;
+   TIMSK1 = 0;
+   TCNT1 = 0;
+   timer1Overflows = 0;
+   TIFR1 = (1 << TOV1);
+   TIMSK1 = (1 << TOIE1);
+   TCCR1B = (1 << CS10);
+   sei();
+ }
+
+ void benchClockStop() {
+   TCCR1B = 0;
+   TIMSK1 = 0;
+ }
+
+ /*
+  * Read the extended counter, accounting for an overflow that is pending
+  * but not yet serviced because interrupts are masked here
+  */
+ bench_ticks_t benchClockRead() {
+   uint8_t sreg = SREG;
+   cli();
+   uint16_t count = TCNT1;
+   uint16_t overflows = timer1Overflows;
+   if ((TIFR1 & (1 << TOV1)) && count < 0x8000) {
+     overflows++;
+   }
+   SREG = sreg;
+   return ((bench_ticks_t)overflows << 16) | count;
+ }
+
+ #else
+
+ #include <chrono>
+
+ void benchClockStart() {}
+ void benchClockStop() {}
+
+ bench_ticks_t benchClockRead() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+     std::chrono::steady_clock::now().time_since_epoch()).count();
+ }
+
+ #endif
@@ -0,0 +1,28 @@
+/*
+ * Bench clock provides a cycle-resolution timer for the microbenchmarks
+ * On the Uno, Timer1 runs unprescaled at F_CPU and overflows are counted
+ * in software; on the host, a monotonic nanosecond clock is used instead
+ */
+
+ #ifndef BENCH_CLOCK_H
+ #define BENCH_CLOCK_H
+
+ #include <Arduino.h>
+
+ #if defined(__AVR__)
+   #define BENCH_TARGET "uno"
+   #define BENCH_UNIT "cycles"
+   #define BENCH_DEFAULT_ITERATIONS 200
+   typedef uint32_t bench_ticks_t;
+ #else
+   #define BENCH_TARGET "native"
+   #define BENCH_UNIT "ns"
+   #define BENCH_DEFAULT_ITERATIONS 100000
+   typedef uint64_t bench_ticks_t;
+ #endif
+
+ void benchClockStart();
+ void benchClockStop();
+ bench_ticks_t benchClockRead();
+
+ #endif // BENCH_CLOCK_H
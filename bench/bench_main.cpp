@@ -0,0 +1,308 @@
+/*
+ * Microbenchmark suite for the firmware hot paths
+ * Builds as the uno-bench firmware (cycles) and as a native program (ns)
+ *
+ * Output is one CSV record per kernel between BEGIN/END markers:
+ *   BENCH_BEGIN,<target>,<unit>
+ *   BENCH,<kernel>,<iterations>,<total>,<per_iteration>
+ *   BENCH_END
+ * Totals have the empty-loop overhead subtracted. tools/bench_compare.py
+ * diffs two captured runs. Report text goes to a discarding sink; a
+ * BENCH_ERROR,report_chunk_overflow,<count> record (and a failing exit
+ * status on the host) means a report step wrote more than one chunk.
+ */
+
+ #include <Arduino.h>
+ #include "system_config.h"
+ #include "interrupts.h"
+ #include "sensors.h"
+ #include "state_machine.h"
+ #include "utilities.h"
+ #include "report_queue.h"
+ #include "isr_shared.h"
+ #include "critical_path.h"
+ #include "transition_audit.h"
+ #include "system_context.h"
+ #include "bench_clock.h"
+ #include <ctype.h>
+
+ #ifndef BENCH_ITERATIONS
+ #define BENCH_ITERATIONS BENCH_DEFAULT_ITERATIONS
+ #endif
+
+ typedef void (*BenchSetup)();
+ typedef void (*BenchKernel)(unsigned long iteration);
+
+ struct BenchCase {
+   const char* name;
+   BenchSetup setup;
+   BenchKernel kernel;
+ };
+
+ // Keeps results observable so kernels are not optimised away
+ static volatile long benchSink = 0;
+
+ /*
+  * Report output for the bench: discards the text, so it cannot mix with
+  * the CSV records, and offers one empty TX buffer's worth of space per
+  * pass like a port that has drained since the last serviceReports()
+  */
+ class ReportSink : public Print {
+   public:
+     ReportSink() : room(0) {}
+
+     void drain() { room = REPORT_CHUNK_MAX; }
+     int availableForWrite() { return room; }
+     size_t write(uint8_t) {
+       if (room > 0) room--;
+       return 1;
+     }
+     size_t write(const uint8_t*, size_t size) {
+       room = size < room ? room - size : 0;
+       return size;
+     }
+
+   private:
+     unsigned int room;
+ };
+
+ static ReportSink reportSink;
+
+ /*
+  * Common firmware state for the kernels: armed, quiet, nominal sensors
+  */
+ static void setupArmedQuiet() {
+   ctx().systemFlags.armed = true;
+   ctx().systemFlags.alarmActive = false;
+   ctx().systemFlags.verboseLogging = false;
+   ctx().systemFlags.logLevel = -1; // below LOG_MINIMAL, silences all logging
+   ctx().currentState = MONITORING;
+   ctx().pendingState = MONITORING;
+   ctx().sensors.pir = false;
+   ctx().sensors.gasSafe = true;
+   ctx().sensors.temperature = 22;
+   ctx().sensors.gasReading = 100;
+ }
+
+ static void setupAlert() {
+   setupArmedQuiet();
+   ctx().currentState = ALERT;
+   ctx().pendingState = ALERT;
+   ctx().sensors.pir = true;
+ }
+
+ static void kernelEmpty(unsigned long) {}
+
+ /*
+  * Thermistor conversion used by readAnalogSensors()
+  */
+ static void kernelThermistor(unsigned long i) {
+   benchSink += convertTemperature(100 + (i % 800));
+ }
+
+ /*
+  * State machine pass with no dirty input and no deadline due (the common
+  * case), which skips evaluation
+  */
+ static void kernelStateMachineIdle(unsigned long) {
+   processStateMachine();
+ }
+
+ /*
+  * Full state machine evaluation that finds nothing to do
+  */
+ static void kernelStateMachineSteady(unsigned long) {
+   markStateInputsDirty(STATE_INPUT_SENSOR);
+   processStateMachine();
+ }
+
+ /*
+  * State machine evaluation in ALERT, including escalation checks
+  */
+ static void kernelStateMachineAlert(unsigned long) {
+   markStateInputsDirty(STATE_INPUT_SENSOR);
+   processStateMachine();
+ }
+
+ /*
+  * Transition log line as built by executeStateTransition()
+  */
+ static void kernelLogFormat(unsigned long i) {
+   SystemState from = (SystemState)(i & 3);
+   SystemState to = (SystemState)((i + 1) & 3);
+   LineBuffer<40> message;
+   ReportWriter(message) << F("STATE: ") << stateToString(from) << F(" -> ") << stateToString(to);
+   benchSink += message.length();
+ }
+
+ /*
+  * One Timer1 input sample through the port debouncer, with the input
+  * bouncing on every other sample
+  */
+ static void kernelDebounceSample(unsigned long i) {
+   debouncePort(ctx().inputPortB, (i & 2) ? 0x3F : 0x00);
+ }
+
+ /*
+  * Debounced PIR edge through the ISR snapshot and processInputEvents(),
+  * including the state machine evaluation it triggers
+  */
+ static void kernelInputEvent(unsigned long i) {
+   uint8_t pirMask = digitalPinToBitMask(PIR_SENSOR_PIN);
+   if (i & 1) {
+     ctx().inputPortB.state |= pirMask;
+     ctx().inputPortB.rise = pirMask;
+   } else {
+     ctx().inputPortB.state &= ~pirMask;
+     ctx().inputPortB.fall = pirMask;
+   }
+   takeIsrSnapshot();
+   processInputEvents();
+   processStateMachine();
+ }
+
+ /*
+  * Command normalisation and dispatch as done by processSerialCommands()
+  */
+ static void kernelCommandParse(unsigned long i) {
+   char line[SERIAL_COMMAND_MAX + 1];
+   strcpy_P(line, (i & 1) ? PSTR(" disarm ") : PSTR("arm"));
+   char* command = trimCommand(line);
+   for (char* p = command; *p; p++) {
+     *p = toupper((unsigned char)*p);
+   }
+   executeCommand(command);
+ }
+
+ /*
+  * One serviceReports() pass of the STATUS report, with a fresh report
+  * queued whenever the last one has drained
+  */
+ static void kernelReportPass(unsigned long) {
+   if (!reportPending()) printSystemStatus();
+   reportSink.drain();
+   serviceReports();
+ }
+
+ static const BenchCase benchCases[] = {
+   {"thermistor_convert", setupArmedQuiet, kernelThermistor},
+   {"state_machine_idle", setupArmedQuiet, kernelStateMachineIdle},
+   {"state_machine_steady", setupArmedQuiet, kernelStateMachineSteady},
+   {"state_machine_alert", setupAlert, kernelStateMachineAlert},
+   {"log_format_transition", setupArmedQuiet, kernelLogFormat},
+   {"debounce_sample", setupArmedQuiet, kernelDebounceSample},
+   {"input_event", setupArmedQuiet, kernelInputEvent},
+   {"command_parse", setupArmedQuiet, kernelCommandParse},
+   {"report_pass", setupArmedQuiet, kernelReportPass},
+ };
+
+ /*
+  * Time one kernel over the given number of iterations
+  */
+ static bench_ticks_t timeKernel(const BenchCase& bench, BenchKernel kernel, unsigned long iterations) {
+   bench.setup();
+   bench_ticks_t start = benchClockRead();
+   for (unsigned long i = 0; i < iterations; i++) {
+     kernel(i);
+   }
+   return benchClockRead() - start;
+ }
+
+ /*
+  * Run every report once over the widest values its fields can hold and
+  * return how many chunks overflowed REPORT_CHUNK_MAX
+  */
+ static unsigned int checkReportChunks() {
+   setupArmedQuiet();
+   ctx().pendingState = ALERT;
+
+   TransitionAudit& audit = ctx().transitionAudit;
+   for (uint8_t i = 0; i < TRANSITION_LOG_SIZE; i++) {
+     TransitionRecord record = {0xFFFFFFFFUL, MONITORING, ALERT, 0xFF, 0xFFFF};
+     audit.log[i] = record;
+   }
+   audit.head = 0;
+   audit.count = TRANSITION_LOG_SIZE;
+   audit.total = 0xFFFFFFFFUL;
+   for (uint8_t from = 0; from < STATE_COUNT; from++) {
+     audit.cancelled[from] = 0xFFFF;
+     for (uint8_t to = 0; to < STATE_COUNT; to++) audit.edgeCount[from][to] = 0xFFFF;
+   }
+
+   CriticalPathStats& critical = ctx().criticalPath;
+   critical.activations = 0xFFFF;
+   critical.lastBuzzerLatency = critical.maxBuzzerLatency = 0xFFFF;
+   critical.lastCommitLatency = critical.maxCommitLatency = 0xFFFFFFFFUL;
+   critical.maxMaskedWindow = 0xFFFF;
+
+   unsigned int before = getReportTruncations();
+   printSystemStatus();
+   printDebugInfo();
+   printTransitionReport();
+   printLatencyReport();
+   printHelpCommands();
+   while (reportPending()) {
+     reportSink.drain();
+     serviceReports();
+   }
+   return getReportTruncations() - before;
+ }
+
+ static bool runBenchmarks() {
+   const unsigned long iterations = BENCH_ITERATIONS;
+
+   Serial.print("BENCH_BEGIN,");
+   Serial.print(BENCH_TARGET);
+   Serial.print(",");
+   Serial.println(BENCH_UNIT);
+
+   setReportOutput(&reportSink);
+   unsigned int truncated = checkReportChunks();
+   if (truncated > 0) {
+     Serial.print("BENCH_ERROR,report_chunk_overflow,");
+     Serial.println(truncated);
+   }
+
+   benchClockStart();
+   for (unsigned int c = 0; c < sizeof(benchCases) / sizeof(benchCases[0]); c++) {
+     const BenchCase& bench = benchCases[c];
+     bench_ticks_t overhead = timeKernel(bench, kernelEmpty, iterations);
+     bench_ticks_t total = timeKernel(bench, bench.kernel, iterations);
+     total = total > overhead ? total - overhead : 0;
+
+     Serial.print("BENCH,");
+     Serial.print(bench.name);
+     Serial.print(",");
+     Serial.print(iterations);
+     Serial.print(",");
+     Serial.print((unsigned long)total);
+     Serial.print(",");
+     Serial.println((double)total / iterations, 1);
+     Serial.flush();
+   }
+   benchClockStop();
+
+   Serial.println("BENCH_END");
+   setReportOutput(NULL);
+   return truncated == 0;
+ }
+
+ static bool benchPassed;
+
+ void setup() {
+   Serial.begin(115200);
+   benchPassed = runBenchmarks();
+ }
+
+ void loop() {
+ }
+
+ #if !defined(__AVR__)
+ static SystemContext benchContext;
+
+ int main() {
+   selectSystemContext(&benchContext);
+   setup();
+   return benchPassed ? 0 : 1;
+ }
+ #endif
@@ -0,0 +1,251 @@
+/*
+ * Fleet load generator: many simulated homes running the firmware at once
+ *
+ *   fleet [--homes N] [--seconds S] [--threads N[,N...]] [--pass-us US]
+ *         [--slice-ms MS] [--seed N] [--per-home OUT.csv]
+ *
+ * Every home is the unmodified firmware (setup()/loop() and both ISRs) on
+ * its own SystemContext and NativeBoard, fed by a seeded event generator
+ * for S seconds of virtual time. Homes run in slices on a work-stealing
+ * pool; a list of thread counts repeats the run at each count and reports
+ * the speedup against the first. That speedup only says something about
+ * scaling when the host has a core per thread, so counts beyond the
+ * hardware threads are flagged. Each home's results depend only on its
+ * seed, so every repeat must produce the same fleet digest.
+ */
+
+ #include "simulated_home.h"
+ #include "work_stealing_pool.h"
+
+ #include <algorithm>
+ #include <memory>
+ #include <string>
+ #include <thread>
+ #include <vector>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+
+ static const char* const eventKindNames[EVENT_KIND_COUNT] = {
+   "motion", "gas danger", "temperature", "gas level", "command"
+ };
+
+ struct FleetOptions {
+   size_t homes;
+   unsigned long seconds;
+   std::vector<unsigned> threads;
+   unsigned long passUs;
+   unsigned long sliceMs;
+   uint64_t seed;
+   const char* perHomePath;
+ };
+
+ struct FleetRun {
+   unsigned threads;
+   double wallSeconds;
+   PoolStats pool;
+   uint64_t digest;
+ };
+
+ typedef std::vector<std::unique_ptr<SimulatedHome>> Fleet;
+
+ static double elapsedSeconds(const struct timespec& from, const struct timespec& to) {
+   return (to.tv_sec - from.tv_sec) + (to.tv_nsec - from.tv_nsec) / 1e9;
+ }
+
+ static FleetRun runFleet(const FleetOptions& options, unsigned threads, Fleet& fleet) {
+   HomeTiming timing = {options.seconds * 1000000UL, options.passUs, 1000000UL / INPUT_SAMPLE_HZ};
+   fleet.clear();
+   for (size_t i = 0; i < options.homes; i++) {
+     fleet.push_back(std::unique_ptr<SimulatedHome>(new SimulatedHome(options.seed + i, DEFAULT_SCENARIO, timing)));
+   }
+
+   unsigned long sliceUs = options.sliceMs * 1000UL;
+   WorkStealingPool pool(threads);
+   struct timespec start, finish;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   PoolStats stats = pool.run(fleet.size(), [&](size_t home) { return fleet[home]->runSlice(sliceUs); });
+   clock_gettime(CLOCK_MONOTONIC, &finish);
+
+   // Combined in home order, so the digest does not depend on scheduling
+   uint64_t digest = 0;
+   for (size_t i = 0; i < fleet.size(); i++) digest = digest * 31 + fleet[i]->stats().digest;
+
+   FleetRun run = {threads, elapsedSeconds(start, finish), stats, digest};
+   return run;
+ }
+
+ static unsigned long percentile(std::vector<unsigned long>& values, double fraction) {
+   if (values.empty()) return 0;
+   size_t index = (size_t)(fraction * (values.size() - 1) + 0.5);
+   std::nth_element(values.begin(), values.begin() + index, values.end());
+   return values[index];
+ }
+
+ static void printLatency(const char* label, std::vector<unsigned long> samples) {
+   if (samples.empty()) {
+     printf("%s: no samples\n", label);
+     return;
+   }
+   double sum = 0;
+   for (size_t i = 0; i < samples.size(); i++) sum += samples[i];
+   printf("%s: n=%zu p50 %.1fms p95 %.1fms p99 %.1fms max %.1fms mean %.1fms\n", label, samples.size(),
+          percentile(samples, 0.5) / 1000.0, percentile(samples, 0.95) / 1000.0,
+          percentile(samples, 0.99) / 1000.0, percentile(samples, 1.0) / 1000.0, sum / samples.size() / 1000.0);
+ }
+
+ static unsigned long maxOf(const std::vector<unsigned long>& values) {
+   return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+ }
+
+ static void printFleetSummary(const FleetOptions& options, const Fleet& fleet) {
+   unsigned long events[EVENT_KIND_COUNT] = {0};
+   unsigned long alerts = 0, alarms = 0, filtered = 0, missed = 0;
+   unsigned long passes = 0, serialBytes = 0;
+   std::vector<unsigned long> detection, critical, homeWorst;
+   size_t worstHome = 0;
+
+   for (size_t i = 0; i < fleet.size(); i++) {
+     const HomeStats& home = fleet[i]->stats();
+     for (int kind = 0; kind < EVENT_KIND_COUNT; kind++) events[kind] += home.events[kind];
+     alerts += home.alerts;
+     alarms += home.alarms;
+     filtered += home.filteredMotion;
+     missed += home.missedCritical;
+     passes += home.passes;
+     serialBytes += home.serialBytes;
+     detection.insert(detection.end(), home.detectionUs.begin(), home.detectionUs.end());
+     critical.insert(critical.end(), home.criticalUs.begin(), home.criticalUs.end());
+     if (!home.detectionUs.empty()) homeWorst.push_back(maxOf(home.detectionUs));
+     if (maxOf(home.detectionUs) > maxOf(fleet[worstHome]->stats().detectionUs)) worstHome = i;
+   }
+
+   unsigned long total = 0;
+   for (int kind = 0; kind < EVENT_KIND_COUNT; kind++) total += events[kind];
+   printf("Events: %lu (", total);
+   for (int kind = 0; kind < EVENT_KIND_COUNT; kind++) {
+     printf("%s%s %lu", kind ? ", " : "", eventKindNames[kind], events[kind]);
+   }
+   printf(")\n");
+   printf("Loop passes: %lu  Serial output: %.0f bytes/home\n", passes,
+          fleet.empty() ? 0.0 : (double)serialBytes / fleet.size());
+   printf("Alerts: %lu  Alarms: %lu (%.2f per home-hour)\n", alerts, alarms,
+          alarms * 3600.0 / ((double)options.seconds * (fleet.empty() ? 1 : fleet.size())));
+   printLatency("Motion -> ALERT", detection);
+   printf("  motion released inside the debounce: %lu\n", filtered);
+   printLatency("Motion + gas danger -> ALARM", critical);
+   printf("  cleared without ALARM: %lu\n", missed);
+   printLatency("Per-home worst motion -> ALERT", homeWorst);
+   if (!homeWorst.empty()) {
+     printf("  slowest home: #%zu (seed %llu)\n", worstHome, (unsigned long long)(options.seed + worstHome));
+   }
+ }
+
+ static bool writePerHome(const char* path, const Fleet& fleet) {
+   FILE* out = fopen(path, "w");
+   if (!out) return false;
+   fprintf(out, "home,events,passes,alerts,alarms,detections,filtered,detect_max_us,critical,critical_max_us,serial_bytes\n");
+   for (size_t i = 0; i < fleet.size(); i++) {
+     const HomeStats& home = fleet[i]->stats();
+     fprintf(out, "%zu,%lu,%lu,%lu,%lu,%zu,%lu,%lu,%zu,%lu,%lu\n", i, home.totalEvents(), home.passes,
+             home.alerts, home.alarms, home.detectionUs.size(), home.filteredMotion, maxOf(home.detectionUs),
+             home.criticalUs.size(), maxOf(home.criticalUs), home.serialBytes);
+   }
+   return fclose(out) == 0;
+ }
+
+ static bool parseThreadList(const char* arg, std::vector<unsigned>& threads) {
+   threads.clear();
+   for (const char* p = arg; *p;) {
+     char* end;
+     unsigned long count = strtoul(p, &end, 10);
+     if (end == p || count == 0) return false;
+     threads.push_back((unsigned)count);
+     p = *end == ',' ? end + 1 : end;
+     if (*end && *end != ',') return false;
+   }
+   return !threads.empty();
+ }
+
+ static int usage() {
+   fprintf(stderr,
+           "usage: fleet [--homes N] [--seconds S] [--threads N[,N...]] [--pass-us US]\n"
+           "             [--slice-ms MS] [--seed N] [--per-home OUT.csv]\n");
+   return 2;
+ }
+
+ int main(int argc, char** argv) {
+   FleetOptions options;
+   options.homes = 1000;
+   options.seconds = 600;
+   options.threads.push_back(std::max(1u, std::thread::hardware_concurrency()));
+   options.passUs = 1000;
+   options.sliceMs = 1000;
+   options.seed = 1;
+   options.perHomePath = NULL;
+
+   for (int i = 1; i < argc; i++) {
+     const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+     if (strcmp(argv[i], "--homes") == 0 && value) {
+       options.homes = strtoul(argv[++i], NULL, 10);
+     } else if (strcmp(argv[i], "--seconds") == 0 && value) {
+       options.seconds = strtoul(argv[++i], NULL, 10);
+     } else if (strcmp(argv[i], "--threads") == 0 && value) {
+       if (!parseThreadList(argv[++i], options.threads)) return usage();
+     } else if (strcmp(argv[i], "--pass-us") == 0 && value) {
+       options.passUs = strtoul(argv[++i], NULL, 10);
+     } else if (strcmp(argv[i], "--slice-ms") == 0 && value) {
+       options.sliceMs = strtoul(argv[++i], NULL, 10);
+     } else if (strcmp(argv[i], "--seed") == 0 && value) {
+       options.seed = strtoull(argv[++i], NULL, 10);
+     } else if (strcmp(argv[i], "--per-home") == 0 && value) {
+       options.perHomePath = argv[++i];
+     } else {
+       return usage();
+     }
+   }
+   if (options.homes == 0 || options.seconds == 0 || options.passUs == 0 || options.sliceMs == 0) return usage();
+
+   printf("Fleet: %zu homes x %lus virtual, loop pass every %luus, %lums slices\n", options.homes,
+          options.seconds, options.passUs, options.sliceMs);
+   unsigned cores = std::thread::hardware_concurrency();
+   for (size_t r = 0; r < options.threads.size(); r++) {
+     if (cores > 0 && options.threads[r] > cores) {
+       printf("Note: %u threads on %u hardware threads; speedup beyond %u is oversubscribed, not scaling\n",
+              options.threads[r], cores, cores);
+       break;
+     }
+   }
+   printf("threads  wall_s  events/s  virtual_s/s  speedup  efficiency  steals\n");
+
+   Fleet fleet;
+   std::vector<FleetRun> runs;
+   for (size_t r = 0; r < options.threads.size(); r++) {
+     FleetRun run = runFleet(options, options.threads[r], fleet);
+     runs.push_back(run);
+
+     unsigned long events = 0;
+     for (size_t i = 0; i < fleet.size(); i++) events += fleet[i]->stats().totalEvents();
+     // Relative to the first thread count in the list
+     double speedup = runs[0].wallSeconds / run.wallSeconds;
+     double efficiency = speedup * runs[0].threads / run.threads;
+     printf("%7u  %6.2f  %8.0f  %11.0f  %6.2fx  %9.0f%%  %6lu\n", run.threads, run.wallSeconds,
+            events / run.wallSeconds, options.seconds * (double)fleet.size() / run.wallSeconds, speedup,
+            efficiency * 100.0, run.pool.steals);
+     fflush(stdout);
+   }
+
+   bool consistent = true;
+   for (size_t r = 1; r < runs.size(); r++) consistent &= runs[r].digest == runs[0].digest;
+   printf("Fleet digest: %016llx%s\n", (unsigned long long)runs[0].digest,
+          runs.size() < 2 ? "" : consistent ? " (identical across runs)" : " (MISMATCH between runs)");
+
+   printFleetSummary(options, fleet);
+
+   if (options.perHomePath && !writePerHome(options.perHomePath, fleet)) {
+     fprintf(stderr, "error: cannot write %s\n", options.perHomePath);
+     return 1;
+   }
+   return consistent ? 0 : 1;
+ }
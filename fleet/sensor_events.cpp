@@ -0,0 +1,136 @@
+/*
+ * Synthetic sensor event generator implementation
+ */
+
+ #include "sensor_events.h"
+ #include <math.h>
+
+ const ScenarioConfig DEFAULT_SCENARIO = {
+   120.0,   // motion episode every 2 minutes on average
+   900.0,   // gas danger every 15 minutes
+   2.0,     // analog readings move every 2 seconds
+   300.0    // a STATUS request every 5 minutes
+ };
+
+ // Analog ranges: temperature stays inside the safe band (~17-28°C),
+ // background gas stays under GAS_WARNING, a gas episode goes well over it
+ #define TEMPERATURE_LOW 470
+ #define TEMPERATURE_HIGH 600
+ #define GAS_BACKGROUND_LOW 60
+ #define GAS_BACKGROUND_HIGH 300
+ #define GAS_DANGER_LEVEL 800
+
+ // Episode lengths, in virtual seconds
+ #define MOTION_MIN_SECONDS 0.5
+ #define MOTION_MAX_SECONDS 12.0
+ #define GAS_DANGER_MIN_SECONDS 3.0
+ #define GAS_DANGER_MAX_SECONDS 30.0
+
+ // The home arms itself this long after boot
+ #define ARM_DELAY_SECONDS 1.0
+
+ void SensorEventGenerator::init(uint64_t seed, const ScenarioConfig& config) {
+   // splitmix64 so neighbouring seeds give unrelated streams
+   seed += 0x9E3779B97F4A7C15ULL;
+   seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+   rngState = (seed ^ (seed >> 31)) | 1;
+
+   scenario = config;
+   motionActive = false;
+   gasDangerActive = false;
+   armed = false;
+   temperatureLevel = TEMPERATURE_LOW + (int)(uniform() * (TEMPERATURE_HIGH - TEMPERATURE_LOW));
+   gasLevel = GAS_BACKGROUND_LOW + (int)(uniform() * (GAS_BACKGROUND_HIGH - GAS_BACKGROUND_LOW));
+
+   due[EVENT_MOTION] = exponentialMicros(scenario.motionInterval);
+   due[EVENT_GAS_DANGER] = exponentialMicros(scenario.gasDangerInterval);
+   due[EVENT_TEMPERATURE] = 0;
+   due[EVENT_GAS_LEVEL] = 0;
+   due[EVENT_COMMAND] = (unsigned long)(ARM_DELAY_SECONDS * 1e6);
+   pickNext();
+ }
+
+ /*
+  * Take the earliest pending event and schedule that source's next one
+  */
+ SensorEvent SensorEventGenerator::next() {
+   SensorEvent event = {(SensorEventKind)nextKind, due[nextKind], false, 0, 0};
+   unsigned long& nextDue = due[nextKind];
+
+   switch (event.kind) {
+     case EVENT_MOTION:
+       motionActive = !motionActive;
+       event.active = motionActive;
+       nextDue += motionActive ? uniformMicros(MOTION_MIN_SECONDS, MOTION_MAX_SECONDS)
+                               : exponentialMicros(scenario.motionInterval);
+       break;
+
+     case EVENT_GAS_DANGER:
+       gasDangerActive = !gasDangerActive;
+       event.active = gasDangerActive;
+       event.level = gasDangerActive ? GAS_DANGER_LEVEL : gasLevel;
+       nextDue += gasDangerActive ? uniformMicros(GAS_DANGER_MIN_SECONDS, GAS_DANGER_MAX_SECONDS)
+                                  : exponentialMicros(scenario.gasDangerInterval);
+       break;
+
+     case EVENT_TEMPERATURE:
+       temperatureLevel = drift(temperatureLevel, 4, TEMPERATURE_LOW, TEMPERATURE_HIGH);
+       event.level = temperatureLevel;
+       nextDue += exponentialMicros(scenario.analogInterval);
+       break;
+
+     case EVENT_GAS_LEVEL:
+       gasLevel = drift(gasLevel, 8, GAS_BACKGROUND_LOW, GAS_BACKGROUND_HIGH);
+       event.level = gasDangerActive ? GAS_DANGER_LEVEL : gasLevel;
+       nextDue += exponentialMicros(scenario.analogInterval);
+       break;
+
+     case EVENT_COMMAND:
+       event.command = armed ? "STATUS\n" : "ARM\n";
+       armed = true;
+       nextDue += exponentialMicros(scenario.commandInterval);
+       break;
+
+     default:
+       break;
+   }
+
+   pickNext();
+   return event;
+ }
+
+ // xorshift64*
+ uint64_t SensorEventGenerator::random() {
+   rngState ^= rngState >> 12;
+   rngState ^= rngState << 25;
+   rngState ^= rngState >> 27;
+   return rngState * 0x2545F4914F6CDD1DULL;
+ }
+
+ // [0, 1)
+ double SensorEventGenerator::uniform() {
+   return (random() >> 11) * (1.0 / 9007199254740992.0);
+ }
+
+ unsigned long SensorEventGenerator::exponentialMicros(double meanSeconds) {
+   return (unsigned long)(-log(1.0 - uniform()) * meanSeconds * 1e6) + 1;
+ }
+
+ unsigned long SensorEventGenerator::uniformMicros(double minSeconds, double maxSeconds) {
+   return (unsigned long)((minSeconds + uniform() * (maxSeconds - minSeconds)) * 1e6);
+ }
+
+ int SensorEventGenerator::drift(int level, int step, int low, int high) {
+   level += (int)(random() % (2 * step + 1)) - step;
+   if (level < low) level = low;
+   if (level > high) level = high;
+   return level;
+ }
+
+ void SensorEventGenerator::pickNext() {
+   nextKind = 0;
+   for (uint8_t kind = 1; kind < EVENT_KIND_COUNT; kind++) {
+     if (due[kind] < due[nextKind]) nextKind = kind;
+   }
+ }
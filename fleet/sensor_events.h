@@ -0,0 +1,69 @@
+/*
+ * Synthetic sensor event generator for one simulated home
+ *
+ * Each input is an independent random process on the home's virtual clock:
+ * motion episodes on the PIR, gas-danger episodes on the digital gas line
+ * (with the gas ADC raised for their duration), drifting temperature and
+ * gas readings, and operator commands. The sequence depends only on the
+ * seed, so a home replays identically whichever thread runs it.
+ */
+
+ #ifndef FLEET_SENSOR_EVENTS_H
+ #define FLEET_SENSOR_EVENTS_H
+
+ #include <stdint.h>
+
+ enum SensorEventKind {
+   EVENT_MOTION,        // PIR level change
+   EVENT_GAS_DANGER,    // digital gas line change
+   EVENT_TEMPERATURE,   // new temperature ADC level
+   EVENT_GAS_LEVEL,     // new gas ADC level
+   EVENT_COMMAND,       // serial command line
+   EVENT_KIND_COUNT
+ };
+
+ struct SensorEvent {
+   SensorEventKind kind;
+   unsigned long at;        // virtual micros()
+   bool active;             // MOTION / GAS_DANGER: episode starting
+   int level;               // ADC value
+   const char* command;     // COMMAND: line including the newline
+ };
+
+ // Mean times between episodes and readings, in virtual seconds
+ struct ScenarioConfig {
+   double motionInterval;
+   double gasDangerInterval;
+   double analogInterval;
+   double commandInterval;
+ };
+
+ extern const ScenarioConfig DEFAULT_SCENARIO;
+
+ class SensorEventGenerator {
+   public:
+     void init(uint64_t seed, const ScenarioConfig& config);
+
+     unsigned long nextAt() const { return due[nextKind]; }
+     SensorEvent next();
+
+   private:
+     uint64_t rngState;
+     ScenarioConfig scenario;
+     unsigned long due[EVENT_KIND_COUNT];
+     uint8_t nextKind;
+     bool motionActive;
+     bool gasDangerActive;
+     bool armed;
+     int temperatureLevel;
+     int gasLevel;
+
+     uint64_t random();
+     double uniform();
+     unsigned long exponentialMicros(double meanSeconds);
+     unsigned long uniformMicros(double minSeconds, double maxSeconds);
+     int drift(int level, int step, int low, int high);
+     void pickNext();
+ };
+
+ #endif // FLEET_SENSOR_EVENTS_H
@@ -0,0 +1,170 @@
+/*
+ * Simulated home implementation
+ * The home's context and board are selected for the length of a slice, so
+ * the firmware (and Serial) act on this home
+ */
+
+ #include "simulated_home.h"
+ #include <avr/interrupt.h>
+
+ unsigned long HomeStats::totalEvents() const {
+   unsigned long total = 0;
+   for (int kind = 0; kind < EVENT_KIND_COUNT; kind++) total += events[kind];
+   return total;
+ }
+
+ SimulatedHome::SimulatedHome(uint64_t seed, const ScenarioConfig& scenario, const HomeTiming& homeTiming)
+   : timing(homeTiming), results(), started(false), nextTickAt(0), nextPassAt(0),
+     motionActive(false), gasDangerActive(false), detectionPending(false), motionOnset(0),
+     criticalPending(false), criticalOnset(0), observedState(IDLE), buzzerOn(false) {
+   generator.init(seed, scenario);
+   results.digest = 14695981039346656037ULL;
+ }
+
+ /*
+  * Advance the home by up to sliceUs of virtual time. Generator events,
+  * Timer1 ticks and loop passes are dispatched in time order; a pass that
+  * stalls the clock on serial output delays whatever falls due meanwhile,
+  * as it would on the board
+  */
+ bool SimulatedHome::runSlice(unsigned long sliceUs) {
+   selectSystemContext(&context);
+   nativeSelectBoard(&board);
+   if (!started) start();
+
+   unsigned long sliceEnd = micros() + sliceUs;
+   if (sliceEnd > timing.durationUs) sliceEnd = timing.durationUs;
+
+   for (;;) {
+     unsigned long eventAt = generator.nextAt();
+     unsigned long dueAt = eventAt < nextTickAt ? eventAt : nextTickAt;
+     if (nextPassAt < dueAt) dueAt = nextPassAt;
+     if (dueAt >= sliceEnd) break;
+     if ((long)(dueAt - micros()) > 0) nativeSetMicros(dueAt);
+
+     if (eventAt == dueAt) {
+       apply(generator.next());
+     } else if (nextTickAt == dueAt) {
+       TIMER1_COMPA_vect();
+       nextTickAt += timing.tickUs;
+     } else {
+       loop();
+       results.passes++;
+       nextPassAt += timing.passUs;
+     }
+     observe();
+   }
+   if ((long)(sliceEnd - micros()) > 0) nativeSetMicros(sliceEnd);
+   results.serialBytes = Serial.bytesWritten();
+
+   bool more = micros() < timing.durationUs;
+   nativeSelectBoard(nullptr);
+   selectSystemContext(nullptr);
+   return more;
+ }
+
+ /*
+  * Boot the firmware with its serial output muted. INPUT_PULLUP leaves the
+  * PIR line high, so it is pulled to its idle level once setup() returns
+  */
+ void SimulatedHome::start() {
+   started = true;
+   Serial.setMuted(true);
+   setup();
+   nativeSetDigitalInput(PIR_SENSOR_PIN, LOW);
+   PCINT0_vect();
+   nextTickAt = micros() + timing.tickUs;
+   nextPassAt = micros();
+   observedState = context.currentState;
+ }
+
+ void SimulatedHome::apply(const SensorEvent& event) {
+   bool wasCritical = motionActive && gasDangerActive;
+   results.events[event.kind]++;
+   record(((uint64_t)event.kind << 56) ^ micros());
+
+   switch (event.kind) {
+     case EVENT_MOTION:
+       motionActive = event.active;
+       nativeSetDigitalInput(PIR_SENSOR_PIN, event.active);
+       if (event.active && context.systemFlags.armed && context.currentState == MONITORING && !detectionPending) {
+         detectionPending = true;
+         motionOnset = micros();
+       }
+       PCINT0_vect();
+       break;
+
+     case EVENT_GAS_DANGER:
+       gasDangerActive = event.active;
+       nativeSetAnalogInput(GAS_A_PIN, event.level);
+       nativeSetDigitalInput(GAS_D_PIN, !event.active);
+       PCINT0_vect();
+       break;
+
+     case EVENT_TEMPERATURE:
+       nativeSetAnalogInput(TEMP_SENSOR_PIN, event.level);
+       break;
+
+     case EVENT_GAS_LEVEL:
+       nativeSetAnalogInput(GAS_A_PIN, event.level);
+       break;
+
+     case EVENT_COMMAND:
+       Serial.inject(event.command);
+       break;
+
+     default:
+       break;
+   }
+
+   // Timed only from the edge that completes the pair: that is what the fast path sees
+   bool critical = motionActive && gasDangerActive;
+   if (critical && !wasCritical && !criticalPending && context.systemFlags.armed && context.currentState != ALARM) {
+     criticalPending = true;
+     criticalOnset = micros();
+   }
+ }
+
+ /*
+  * Compare the firmware's state and outputs with what was injected
+  */
+ void SimulatedHome::observe() {
+   if (context.currentState != observedState) {
+     record(((uint64_t)context.currentState << 56) ^ micros());
+     if (context.currentState == ALERT) results.alerts++;
+     observedState = context.currentState;
+   }
+
+   bool buzzer = nativeGetDigitalOutput(BUZZER_PIN);
+   if (buzzer && !buzzerOn) results.alarms++;
+   buzzerOn = buzzer;
+
+   if (detectionPending) {
+     if (context.currentState == ALERT || context.currentState == ALARM) {
+       results.detectionUs.push_back(micros() - motionOnset);
+       detectionPending = false;
+     } else if (!motionActive && !context.sensors.pir && context.pendingState == context.currentState) {
+       // Released before the ALERT debounce committed
+       results.filteredMotion++;
+       detectionPending = false;
+     }
+   }
+
+   if (criticalPending) {
+     if (context.currentState == ALARM) {
+       results.criticalUs.push_back(micros() - criticalOnset);
+       criticalPending = false;
+     } else if (!(motionActive && gasDangerActive) && !criticalPathLatched()) {
+       results.missedCritical++;
+       criticalPending = false;
+     }
+   }
+ }
+
+ // FNV-1a over 64-bit words
+ void SimulatedHome::record(uint64_t value) {
+   for (int shift = 0; shift < 64; shift += 8) {
+     results.digest ^= (value >> shift) & 0xFF;
+     results.digest *= 1099511628211ULL;
+   }
+ }
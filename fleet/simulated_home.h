@@ -0,0 +1,78 @@
+/*
+ * One simulated home: a firmware instance on its own board and context,
+ * driven by a synthetic event generator under virtual time
+ *
+ * A home runs in slices so a pool can interleave thousands of them; any
+ * thread may run the next slice, since runSlice() selects the home's
+ * context and board on entry. Everything observable about the run is
+ * collected in HomeStats.
+ */
+
+ #ifndef FLEET_SIMULATED_HOME_H
+ #define FLEET_SIMULATED_HOME_H
+
+ #include <Arduino.h>
+ #include "system_context.h"
+ #include "sensor_events.h"
+ #include <vector>
+
+ // Virtual-time schedule shared by every home
+ struct HomeTiming {
+   unsigned long durationUs;   // virtual run length
+   unsigned long passUs;       // loop() period
+   unsigned long tickUs;       // Timer1 compare period
+ };
+
+ struct HomeStats {
+   unsigned long events[EVENT_KIND_COUNT];   // injected, by kind
+   unsigned long passes;                     // loop() calls
+   unsigned long alerts;                     // entries into ALERT
+   unsigned long alarms;                     // buzzer rising edges
+   unsigned long filteredMotion;             // motion gone before ALERT committed
+   unsigned long missedCritical;             // motion + gas danger cleared with no ALARM
+   std::vector<unsigned long> detectionUs;   // motion onset -> ALERT or ALARM
+   std::vector<unsigned long> criticalUs;    // motion + gas danger onset -> ALARM
+   unsigned long serialBytes;
+   uint64_t digest;                          // order-sensitive hash of the run
+
+   unsigned long totalEvents() const;
+ };
+
+ class SimulatedHome {
+   public:
+     SimulatedHome(uint64_t seed, const ScenarioConfig& scenario, const HomeTiming& timing);
+     SimulatedHome(const SimulatedHome&) = delete;
+     SimulatedHome& operator=(const SimulatedHome&) = delete;
+
+     // Run up to sliceUs of virtual time; false once the run is complete
+     bool runSlice(unsigned long sliceUs);
+
+     const HomeStats& stats() const { return results; }
+
+   private:
+     SystemContext context;
+     NativeBoard board;
+     SensorEventGenerator generator;
+     HomeTiming timing;
+     HomeStats results;
+     bool started;
+     unsigned long nextTickAt;
+     unsigned long nextPassAt;
+
+     // Detection tracking, in virtual micros()
+     bool motionActive;
+     bool gasDangerActive;
+     bool detectionPending;
+     unsigned long motionOnset;
+     bool criticalPending;
+     unsigned long criticalOnset;
+     SystemState observedState;
+     bool buzzerOn;
+
+     void start();
+     void apply(const SensorEvent& event);
+     void observe();
+     void record(uint64_t value);
+ };
+
+ #endif // FLEET_SIMULATED_HOME_H
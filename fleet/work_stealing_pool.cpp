@@ -0,0 +1,99 @@
+/*
+ * Work-stealing pool implementation
+ */
+
+ #include "work_stealing_pool.h"
+ #include <atomic>
+ #include <condition_variable>
+ #include <thread>
+
+ WorkStealingPool::WorkStealingPool(unsigned count) {
+   if (count == 0) count = 1;
+   for (unsigned i = 0; i < count; i++) workers.push_back(std::unique_ptr<Worker>(new Worker()));
+ }
+
+ bool WorkStealingPool::popLocal(Worker& worker, size_t& task) {
+   std::lock_guard<std::mutex> guard(worker.lock);
+   if (worker.tasks.empty()) return false;
+   task = worker.tasks.back();
+   worker.tasks.pop_back();
+   return true;
+ }
+
+ /*
+  * Take the oldest task of the first non-empty victim after the thief
+  */
+ bool WorkStealingPool::steal(unsigned thief, size_t& task) {
+   for (size_t offset = 1; offset < workers.size(); offset++) {
+     Worker& victim = *workers[(thief + offset) % workers.size()];
+     std::lock_guard<std::mutex> guard(victim.lock);
+     if (victim.tasks.empty()) continue;
+     task = victim.tasks.front();
+     victim.tasks.pop_front();
+     return true;
+   }
+   return false;
+ }
+
+ PoolStats WorkStealingPool::run(size_t count, const Task& task) {
+   // Deal tasks round-robin; stealing evens out whatever imbalance remains
+   for (size_t i = 0; i < count; i++) workers[i % workers.size()]->tasks.push_back(i);
+
+   std::atomic<size_t> remaining(count);
+   std::atomic<size_t> queued(count);       // tasks sitting in a deque
+   std::atomic<unsigned> sleeping(0);
+   std::mutex idleLock;
+   std::condition_variable idleWake;
+   std::atomic<unsigned long> runs(0);
+   std::atomic<unsigned long> steals(0);
+   std::vector<std::thread> threads;
+
+   // Wake sleepers after queued or remaining changed. A sleeper counts
+   // itself before testing both, so either it sees the change or this sees it
+   auto wake = [&](bool all) {
+     if (sleeping.load() == 0) return;
+     std::lock_guard<std::mutex> guard(idleLock);
+     if (all) idleWake.notify_all(); else idleWake.notify_one();
+   };
+
+   for (unsigned w = 0; w < workers.size(); w++) {
+     threads.push_back(std::thread([&, w]() {
+       Worker& own = *workers[w];
+       unsigned long localRuns = 0;
+       unsigned long localSteals = 0;
+       while (remaining.load() > 0) {
+         size_t id;
+         if (!popLocal(own, id)) {
+           if (!steal(w, id)) {
+             // Everything left is running elsewhere: sleep until a task is
+             // requeued or the last one finishes
+             std::unique_lock<std::mutex> idle(idleLock);
+             sleeping++;
+             idleWake.wait(idle, [&]() { return queued.load() > 0 || remaining.load() == 0; });
+             sleeping--;
+             continue;
+           }
+           localSteals++;
+         }
+         queued--;
+         localRuns++;
+         if (task(id)) {
+           {
+             std::lock_guard<std::mutex> guard(own.lock);
+             own.tasks.push_back(id);
+           }
+           queued++;
+           wake(false);
+         } else if (--remaining == 0) {
+           wake(true);
+         }
+       }
+       runs += localRuns;
+       steals += localSteals;
+     }));
+   }
+   for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+   PoolStats stats = {runs.load(), steals.load()};
+   return stats;
+ }
@@ -0,0 +1,48 @@
+/*
+ * Work-stealing pool for resumable tasks
+ *
+ * Every worker owns a deque of task ids. It takes work from the back of its
+ * own deque and, when that is empty, steals from the front of another's. A
+ * task that returns true has more to do and goes back on the back of the
+ * deque of whichever worker ran it, so a worker keeps its tasks warm while
+ * idle workers take the oldest waiting ones. A worker that finds nothing
+ * to take sleeps until a task is requeued or the run is over.
+ */
+
+ #ifndef FLEET_WORK_STEALING_POOL_H
+ #define FLEET_WORK_STEALING_POOL_H
+
+ #include <stddef.h>
+ #include <deque>
+ #include <functional>
+ #include <memory>
+ #include <mutex>
+ #include <vector>
+
+ struct PoolStats {
+   unsigned long runs;     // task invocations
+   unsigned long steals;   // tasks taken from another worker
+ };
+
+ class WorkStealingPool {
+   public:
+     typedef std::function<bool(size_t task)> Task;
+
+     explicit WorkStealingPool(unsigned workers);
+
+     // Run tasks 0..count-1 until each has returned false
+     PoolStats run(size_t count, const Task& task);
+
+   private:
+     struct Worker {
+       std::mutex lock;
+       std::deque<size_t> tasks;
+     };
+
+     std::vector<std::unique_ptr<Worker>> workers;
+
+     bool popLocal(Worker& worker, size_t& task);
+     bool steal(unsigned thief, size_t& task);
+ };
+
+ #endif // FLEET_WORK_STEALING_POOL_H
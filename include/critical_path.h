@@ -0,0 +1,30 @@
+/*
+ * Critical Path header declares the bounded-latency alarm fast path
+ */
+
+ #ifndef CRITICAL_PATH_H
+ #define CRITICAL_PATH_H
+
+ #include "system_config.h"
+
+ // Fast-path state owned by the main loop. The ISR's side of each latch is
+ // published in isrPublished (isr_shared.h)
+ struct CriticalPathStats {
+   volatile bool armed;                   // loop -> ISR: armed and not yet in ALARM
+   volatile uint8_t committedLatches;     // loop -> ISR: isrPublished.fastPathLatches handled so far
+   unsigned int lastBuzzerLatency;
+   unsigned int maxBuzzerLatency;
+   unsigned long lastCommitLatency;       // us from ISR entry to ALARM committed
+   unsigned long maxCommitLatency;
+   unsigned int activations;
+   unsigned int maxMaskedWindow;          // longest interrupts-off stretch, us; written masked only
+ };
+
+ void checkCriticalFastPath(bool pir, bool gasSafe, unsigned long edgeMicros);
+ bool criticalPathLatched();
+ void publishCriticalArming();
+ void commitCriticalAlarm();
+ void noteMaskedWindow(unsigned long startMicros);
+ void printLatencyReport();
+
+ #endif // CRITICAL_PATH_H
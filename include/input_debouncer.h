@@ -0,0 +1,55 @@
+/*
+ * Input Debouncer header declares the bit-parallel port debouncer
+ *
+ * Each port byte carries a 2-bit vertical counter per input: ct1:ct0 hold
+ * bit 1 and bit 0 of all eight counters side by side. A counter is reset
+ * while its input agrees with the debounced state and counts every sample
+ * that disagrees; on the DEBOUNCE_SAMPLES-th consecutive disagreement the
+ * debounced bit toggles and an edge is recorded. The update is the same
+ * handful of logic instructions however many of the eight inputs are used.
+ */
+
+ #ifndef INPUT_DEBOUNCER_H
+ #define INPUT_DEBOUNCER_H
+
+ #include <Arduino.h>
+
+ // Debounced view of one 8-bit input port
+ struct PortDebouncer {
+   uint8_t state;   // debounced levels
+   uint8_t ct0;     // vertical counter, bit 0
+   uint8_t ct1;     // vertical counter, bit 1
+   uint8_t rise;    // 0->1 edges since the reader last cleared them
+   uint8_t fall;    // 1->0 edges since the reader last cleared them
+ };
+
+ /*
+  * Start from a known level with all counters reset and no edges pending
+  */
+ inline void initPortDebouncer(volatile PortDebouncer& port, uint8_t sample) {
+   port.state = sample;
+   port.ct0 = 0xFF;
+   port.ct1 = 0xFF;
+   port.rise = 0;
+   port.fall = 0;
+ }
+
+ /*
+  * Feed one raw port sample (ISR context)
+  */
+ inline void debouncePort(volatile PortDebouncer& port, uint8_t sample) {
+   uint8_t state = port.state;
+   uint8_t delta = sample ^ state;
+   uint8_t ct0 = ~(port.ct0 & delta);
+   uint8_t ct1 = ct0 ^ (port.ct1 & delta);
+   uint8_t toggle = delta & ct0 & ct1;
+
+   state ^= toggle;
+   port.state = state;
+   port.ct0 = ct0;
+   port.ct1 = ct1;
+   port.rise |= toggle & state;
+   port.fall |= toggle & ~state;
+ }
+
+ #endif // INPUT_DEBOUNCER_H
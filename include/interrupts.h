@@ -8,12 +8,19 @@
  #include "system_config.h"
  #include "sensors.h"
  
+ // Counters behind the 1-second tick
+ struct TimerEvents {
+   uint8_t sampleTicks;       // Timer1 samples into the current second (ISR only)
+   uint8_t lastSecondTick;    // isrSnapshot.secondTicks already handled
+   int seconds;               // ticks handled, for the periodic log
+ };
+ 
  // Interrupt setup
  void setupPinChangeInterrupts();
  void setupTimerInterrupt();
  
  // Interrupt processing
- void processPCIEvents();
+ void processInputEvents();
  void processTimerEvents();
  
  #endif // INTERRUPTS_H
\ No newline at end of file
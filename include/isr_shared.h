@@ -0,0 +1,78 @@
+/*
+ * ISR Shared header declares the state the interrupt handlers publish to
+ * the main loop, and the sequence lock that keeps the loop's copy coherent
+ *
+ * ISR -> loop: handlers change published data between seqWriteBegin() and
+ * seqWriteEnd(), which leave the sequence odd while a write is under way.
+ * The loop copies everything into isrSnapshot once per pass and retries if
+ * the sequence moved during the copy, so multi-byte values never tear and
+ * interrupts are never masked to read them. Both handlers share one lock;
+ * AVR ISRs do not nest, so two writers never overlap.
+ *
+ * Loop -> ISR: the loop only writes single bytes, or uses ATOMIC_BLOCK when
+ * a handler read-modify-writes the same data.
+ */
+
+ #ifndef ISR_SHARED_H
+ #define ISR_SHARED_H
+
+ #include "system_config.h"
+ #include <util/atomic.h>
+
+ // Compiler barrier: keeps published accesses inside the sequence bumps
+ #define SEQ_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+ struct SeqLock {
+   volatile uint8_t sequence;   // odd while a writer is inside
+ };
+
+ // Writer side (ISR context)
+ inline void seqWriteBegin(SeqLock& lock) {
+   lock.sequence = lock.sequence + 1;
+   SEQ_BARRIER();
+ }
+
+ inline void seqWriteEnd(SeqLock& lock) {
+   SEQ_BARRIER();
+   lock.sequence = lock.sequence + 1;
+ }
+
+ // Reader side: copy between the two calls, repeat while seqReadRetry() is true.
+ // 8 bits is plenty: a wrap needs 128 writes inside one short copy
+ inline uint8_t seqReadBegin(const SeqLock& lock) {
+   uint8_t sequence = lock.sequence;
+   SEQ_BARRIER();
+   return sequence;
+ }
+
+ inline bool seqReadRetry(const SeqLock& lock, uint8_t sequence) {
+   SEQ_BARRIER();
+   return (sequence & 1) || lock.sequence != sequence;
+ }
+
+ // Written by the ISRs under isrLock, alongside inputPortB
+ struct IsrPublished {
+   uint8_t secondTicks;                 // 1-second Timer1 ticks, wrapping
+   bool statusLed;                      // heartbeat level, toggled each second
+   uint8_t fastPathLatches;             // critical fast-path latches, wrapping
+   unsigned long fastPathEdgeMicros;    // micros() at ISR entry for the last latch
+   unsigned int fastPathBuzzerLatency;  // us from ISR entry to buzzer pin driven
+ };
+
+ // The loop's copy for the current pass
+ struct IsrSnapshot {
+   uint8_t inputLevels;     // debounced port B levels
+   uint8_t inputRise;       // edges not yet acknowledged with ackInputEdges()
+   uint8_t inputFall;
+   uint8_t secondTicks;
+   bool statusLed;
+   uint8_t fastPathLatches;
+   unsigned long fastPathEdgeMicros;
+   unsigned int fastPathBuzzerLatency;
+ };
+
+ void takeIsrSnapshot();
+ void ackInputEdges(uint8_t rise, uint8_t fall);
+ unsigned int getIsrSnapshotRetries();
+
+ #endif // ISR_SHARED_H
@@ -0,0 +1,46 @@
+/*
+ * Memory Monitor header declares stack painting and SRAM high-water-mark
+ * instrumentation
+ */
+
+ #ifndef MEMORY_MONITOR_H
+ #define MEMORY_MONITOR_H
+
+ #include "system_config.h"
+
+ // Loop phases tracked for per-phase stack peaks
+ enum LoopPhase {
+   PHASE_SETUP,
+   PHASE_SENSE,
+   PHASE_THINK,
+   PHASE_ACT,
+   PHASE_MONITOR,
+   PHASE_COUNT
+ };
+
+ // Steps of the memory report embedded in DEBUG
+ enum MemoryReportStep {
+   MEMORY_FREE,
+   MEMORY_STACK,
+   MEMORY_HEAP,
+   MEMORY_LARGEST,
+   MEMORY_MARGIN,
+   MEMORY_PHASES,
+   MEMORY_CLOSEST,
+   MEMORY_REPORT_STEPS
+ };
+
+ // Canary byte written over free SRAM before main() runs
+ #define STACK_CANARY 0xC5
+
+ void memoryMonitorInit();
+ void memoryCheckpoint(LoopPhase phase);
+
+ unsigned int getStackHighWaterMark();
+ unsigned int getHeapHighWaterMark();
+ unsigned int getLargestFreeBlock();
+ unsigned int getFreeGap();
+ unsigned int getPhaseStackPeak(LoopPhase phase);
+ bool memoryReportStep(uint8_t step, ReportWriter& out);
+
+ #endif // MEMORY_MONITOR_H
@@ -0,0 +1,45 @@
+/*
+ * Report Queue header declares resumable, chunked report output
+ *
+ * A report is a step function that writes one short chunk (normally one
+ * line) per call and returns false once it has nothing left:
+ *   bool statusReportStep(uint8_t step, ReportWriter& out);
+ * serviceReports() runs once per loop pass and only sends a chunk when
+ * the serial TX buffer can take all of it, so a long report never blocks
+ * the loop and resumes on the next pass where it stopped.
+ */
+
+ #ifndef REPORT_QUEUE_H
+ #define REPORT_QUEUE_H
+
+ #include "system_config.h"
+
+ // Largest chunk a step may write; the 63 bytes an empty Uno TX buffer can hold
+ #define REPORT_CHUNK_MAX 63
+
+ // Reports waiting behind the one being sent
+ #define REPORT_QUEUE_SIZE 4
+
+ typedef bool (*ReportStep)(uint8_t step, ReportWriter& out);
+
+ // Reports waiting, the one being sent and the chunk waiting for TX space
+ struct ReportQueue {
+   ReportStep waiting[REPORT_QUEUE_SIZE];
+   uint8_t head;
+   uint8_t count;
+   ReportStep active;
+   uint8_t activeStep;                    // next step of the active report
+   LineBuffer<REPORT_CHUNK_MAX> pending;
+   unsigned long passMax;                 // longest serviceReports() pass, us
+   unsigned int truncatedChunks;          // steps that wrote more than REPORT_CHUNK_MAX
+   Print* output;                         // NULL sends to Serial
+ };
+
+ bool queueReport(ReportStep report);
+ void serviceReports();
+ bool reportPending();
+ unsigned long getReportPassMax();
+ unsigned int getReportTruncations();
+ void setReportOutput(Print* output);
+
+ #endif // REPORT_QUEUE_H
@@ -0,0 +1,95 @@
+/*
+ * Report Writer header declares the zero-allocation output helpers used for
+ * logging, reports and command replies
+ *
+ * ReportWriter streams typed values straight to any Print (usually Serial):
+ *   ReportWriter(Serial) << F("Temp: ") << ctx().sensors.temperature << eol;
+ * ReportLine does the same and terminates the line when it goes out of
+ * scope, which is what the LOG_* macros use. LineBuffer is a fixed-capacity
+ * Print for text that has to be assembled before it is sent.
+ * Nothing here touches the heap.
+ */
+
+ #ifndef REPORT_WRITER_H
+ #define REPORT_WRITER_H
+
+ #include <Arduino.h>
+
+ // Line terminator marker
+ enum ReportEol { eol };
+
+ // Fixed-point rendering of a floating-point value
+ struct ReportFixed {
+   double value;
+   uint8_t digits;
+ };
+
+ inline ReportFixed fixed(double value, uint8_t digits) {
+   ReportFixed f = {value, digits};
+   return f;
+ }
+
+ /*
+  * Typed append operations on top of Print
+  */
+ class ReportWriter {
+   public:
+     explicit ReportWriter(Print& out) : out(out) {}
+
+     ReportWriter& operator<<(const __FlashStringHelper* text) { out.print(text); return *this; }
+     ReportWriter& operator<<(const char* text) { out.print(text); return *this; }
+     ReportWriter& operator<<(char c) { out.print(c); return *this; }
+     ReportWriter& operator<<(int value) { out.print(value); return *this; }
+     ReportWriter& operator<<(unsigned int value) { out.print(value); return *this; }
+     ReportWriter& operator<<(long value) { out.print(value); return *this; }
+     ReportWriter& operator<<(unsigned long value) { out.print(value); return *this; }
+     ReportWriter& operator<<(const ReportFixed& value) { out.print(value.value, value.digits); return *this; }
+     ReportWriter& operator<<(ReportEol) { out.println(); return *this; }
+
+   protected:
+     Print& out;
+ };
+
+ /*
+  * A single output line, terminated when the temporary is destroyed
+  */
+ class ReportLine : public ReportWriter {
+   public:
+     explicit ReportLine(Print& out) : ReportWriter(out) {}
+     ~ReportLine() { out.println(); }
+ };
+
+ /*
+  * Fixed-capacity, always NUL-terminated text buffer; excess input is
+  * dropped and remembered until the next clear()
+  */
+ template <uint8_t N>
+ class LineBuffer : public Print {
+   public:
+     LineBuffer() : len(0), dropped(false) { text[0] = '\0'; }
+
+     size_t write(uint8_t c) {
+       if (len >= N) {
+         dropped = true;
+         return 0;
+       }
+       text[len++] = c;
+       text[len] = '\0';
+       return 1;
+     }
+     using Print::write;
+
+     const char* c_str() const { return text; }
+     char* data() { return text; }
+     uint8_t length() const { return len; }
+     bool full() const { return len >= N; }
+     bool truncated() const { return dropped; }
+     void clear() { len = 0; dropped = false; text[0] = '\0'; }
+
+   private:
+     char text[N + 1];
+     uint8_t len;
+     bool dropped;
+ };
+
+ #endif // REPORT_WRITER_H
@@ -0,0 +1,49 @@
+/*
+ * Sampling Policy header declares the per-channel analog sampling schedule
+ */
+
+ #ifndef SAMPLING_POLICY_H
+ #define SAMPLING_POLICY_H
+
+ #include "system_config.h"
+
+ // Analog channels sampled on their own schedules
+ enum AnalogChannel {
+   CHANNEL_TEMP,
+   CHANNEL_GAS,
+   ANALOG_CHANNEL_COUNT
+ };
+
+ #define CHANNEL_BIT(channel) (1 << (channel))
+
+ // How often one channel is sampled
+ struct SamplingPolicy {
+   uint16_t interval[STATE_COUNT];   // ms between samples, by SystemState
+   uint8_t maxBackoff;               // interval doublings allowed while the signal is flat
+   uint8_t flatSamples;              // consecutive flat samples per doubling
+   int16_t flatDelta;                // largest change still counted as flat (channel units)
+ };
+
+ // Live schedule for one channel
+ struct ChannelSchedule {
+   uint16_t intervalMs;     // current interval, backoff included
+   uint8_t backoff;         // doublings applied
+   uint8_t flatCount;       // flat samples since the last doubling
+   int lastValue;
+ };
+
+ // Timer1 side: ticks left until each channel is due, and the reload values
+ struct SamplingTimers {
+   volatile uint16_t countdown[ANALOG_CHANNEL_COUNT];
+   volatile uint16_t reload[ANALOG_CHANNEL_COUNT];
+   volatile uint8_t due;            // CHANNEL_BIT mask of channels due
+   SystemState scheduledState;      // state the schedules were last computed for
+ };
+
+ void samplingInit();
+ void samplingTick();
+ uint8_t takeDueChannels();
+ void recordChannelSample(AnalogChannel channel, int value);
+ void printSamplingChannel(AnalogChannel channel, ReportWriter& out);
+
+ #endif // SAMPLING_POLICY_H
@@ -7,11 +7,27 @@
  
  #include "system_config.h"
 
+ // Command line being received; completed by CR/LF or a quiet period
+ struct CommandInput {
+   LineBuffer<SERIAL_COMMAND_MAX> line;
+   unsigned long lastByte;          // millis() of the last byte received
+ };
+
+ // Out-of-range warning repeat limiting, per analog channel
+ struct SensorWarnings {
+   bool tempWarned;
+   bool gasWarned;
+   unsigned long tempWarnedAt;
+   unsigned long gasWarnedAt;
+ };
+
  void readAnalogSensors();
+ int convertTemperature(int adcValue);
  void processSerialCommands();
+ char* trimCommand(char* line);
+ void executeCommand(const char* command);
  void printHelpCommands();
  void printDebugInfo();
- int getFreeRAM();
 
  
  #endif // SENSORS_H
\ No newline at end of file
@@ -7,10 +7,52 @@
  
  #include "system_config.h"
  
+ // Conditions that can drive a transition, recorded as a bit mask
+ #define TRIGGER_MOTION      0x01
+ #define TRIGGER_GAS_DANGER  0x02
+ #define TRIGGER_GAS_HIGH    0x04
+ #define TRIGGER_TEMP_HIGH   0x08
+ #define TRIGGER_TEMP_LOW    0x10
+ #define TRIGGER_COMMAND     0x20
+ #define TRIGGER_NAME_COUNT  6
+ 
+ // Inputs processStateMachine() depends on. A pass with none of them dirty
+ // and no deadline due (debounce expiry, ALARM_TIMEOUT) skips evaluation
+ #define STATE_INPUT_SENSOR   0x01   // debounced digital edge
+ #define STATE_INPUT_ANALOG   0x02   // new temperature or gas value
+ #define STATE_INPUT_COMMAND  0x04   // ARM/DISARM
+ #define STATE_INPUT_STATE    0x08   // state changed; re-evaluate from the new one
+ #define STATE_INPUT_ALL      0x0F
+ 
+ struct StateEvaluation {
+   uint8_t dirtyInputs;            // STATE_INPUT_* bits changed since the last evaluation
+   bool deadlinePending;
+   unsigned long nextDeadline;     // earliest millis() at which a clean pass must still evaluate
+   unsigned long evaluations;
+   unsigned long skipped;
+ };
+ 
+ // Streams a trigger mask as space-separated names
+ struct TriggerNames {
+   uint8_t mask;
+ };
+ 
+ inline TriggerNames triggerNames(uint8_t mask) {
+   TriggerNames names = {mask};
+   return names;
+ }
+ 
+ ReportWriter& operator<<(ReportWriter& out, const TriggerNames& names);
+ 
  void processStateMachine();
+ void markStateInputsDirty(uint8_t inputs);
+ unsigned long getStateEvaluations();
+ unsigned long getStateEvaluationsSkipped();
  void executeStateActions();
- void executeStateTransition(SystemState state);
- void logTriggerConditions();
+ // latchedTriggers: conditions seen by an ISR that the debounced sensor state may not show yet
+ void executeStateTransition(SystemState state, uint8_t latchedTriggers = 0);
+ void logTriggerConditions(uint8_t triggers);
+ uint8_t getTriggerMask();
  bool shouldEscalateToAlarm();
  bool alertConditionsCleared();
  unsigned long getStateDebounceTime(SystemState state); 
@@ -7,6 +7,9 @@
 
  #include <Arduino.h>
  #include <avr/interrupt.h>
+ #include "report_writer.h"
+ #include "input_debouncer.h"
+ #include "timestamps.h"
  
  // Input pins
  extern const int PIR_SENSOR_PIN;
@@ -19,13 +22,25 @@
  extern const int ALARM_LED_PIN;
  extern const int BUZZER_PIN;
  
+ // Digital inputs are sampled by Timer1; an input must hold for
+ // DEBOUNCE_SAMPLES samples (fixed by the 2-bit vertical counters),
+ // i.e. 50 ms at 80 Hz. The 1-second timer tick is derived from it
+ #define INPUT_SAMPLE_HZ 80
+ #define DEBOUNCE_SAMPLES 4
+ 
  // Timing constants 
- extern const unsigned long DEBOUNCE_DELAY;
  extern const unsigned long STATE_DEBOUNCE_DELAY;
  extern const unsigned long ALARM_TIMEOUT;
- extern const unsigned long TEMP_READ_INTERVAL;
  extern const unsigned long SERIAL_UPDATE_INTERVAL;
  extern const unsigned long ALERT_TO_ALARM_DELAY;
+ extern const unsigned long SERIAL_COMMAND_TIMEOUT;
+ 
+ // Longest accepted command line
+ #define SERIAL_COMMAND_MAX 24
+ 
+ // Critical alarm fast path: TRIGGER_* bits that must all be active
+ extern const bool CRITICAL_FAST_PATH_ENABLED;
+ extern const uint8_t CRITICAL_TRIGGERS;
  
  // Threshold constants
  extern const long GAS_WARNING;
@@ -39,60 +54,47 @@
    ALERT,
    ALARM
  };
+ #define STATE_COUNT 4
  
- // Sensor state structure
+ // Sensor state structure (packed: levels are bits, change times are Stamp16)
  struct SensorStates {
-   bool pir;
-   bool gasSafe;
-   bool pirPrevious;
-   bool gasPrevious;
-   unsigned long pirLastChange;
-   unsigned long gasLastChange;
-   int temperature;
-   int gasReading;
-   unsigned long tempLastRead;
+   bool pir : 1;
+   bool gasSafe : 1;
+   bool pirPrevious : 1;
+   bool gasPrevious : 1;
+   Stamp16 pirLastChange;
+   Stamp16 gasLastChange;
+   int16_t temperature;
+   int16_t gasReading;
  };
+ static_assert(sizeof(SensorStates) <= 10, "SensorStates exceeds its 10-byte SRAM budget");
  
- // System flags structure
+ // System flags structure (packed). Loop-owned only; the status LED level
+ // the Timer1 ISR toggles is published through isr_shared.h
  struct SystemFlags {
-   bool armed;
-   bool alarmActive;
-   bool statusLedState;
-   unsigned long alarmStartTime;
-   unsigned long lastStateChange;
-   bool verboseLogging;
-   int logLevel; // 0=minimal, 1=normal, 2=verbose
+   bool armed : 1;
+   bool alarmActive : 1;
+   bool verboseLogging : 1;
+   int8_t logLevel; // 0=minimal, 1=normal, 2=verbose
+   Stamp16 alarmStartTime;
  };
+ static_assert(sizeof(SystemFlags) <= 8, "SystemFlags exceeds its 8-byte SRAM budget");
 
- // Interrupt flags (volatile)
- extern volatile bool pirChange;
- extern volatile bool gasChange;
- extern volatile bool timerTick;
- extern volatile bool pciTriggered;
- 
- // State variables
- extern SystemState currentState;
- extern SystemState previousState;
- extern SystemState pendingState;
- extern unsigned long stateChangeTime;
- 
- // System data structures
- extern SensorStates sensors;
- extern SystemFlags systemFlags;
+ // The live state (ctx().currentState, ctx().sensors, ...) is kept in
+ // SystemContext; see system_context.h
  
- // Timing variables
- extern unsigned long lastSerialUpdate;
-  
  // Initialisation
  void systemInit();
  
  // Utility functions
- String stateToString(SystemState state);
+ const __FlashStringHelper* stateToString(SystemState state);
  void printSystemStatus();
  void periodicStatusUpdate();
  
- #define LOG_MINIMAL(msg) if (systemFlags.logLevel >= 0) Serial.println(msg)
- #define LOG_NORMAL(msg) if (systemFlags.logLevel >= 1) Serial.println(msg)
- #define LOG_VERBOSE(msg) if (systemFlags.logLevel >= 2) Serial.println(msg)
+ // Log a line without heap allocation; msg is a << chain, e.g.
+ // LOG_NORMAL(F("STATE: ") << stateToString(ctx().currentState))
+ #define LOG_MINIMAL(msg) if (ctx().systemFlags.logLevel >= 0) ReportLine(Serial) << msg
+ #define LOG_NORMAL(msg) if (ctx().systemFlags.logLevel >= 1) ReportLine(Serial) << msg
+ #define LOG_VERBOSE(msg) if (ctx().systemFlags.logLevel >= 2) ReportLine(Serial) << msg
 
  #endif // SYSTEM_CONFIG_H
\ No newline at end of file
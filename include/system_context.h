@@ -0,0 +1,88 @@
+/*
+ * System Context header gathers all mutable firmware state into one struct
+ *
+ * Firmware code reaches its state through ctx(), e.g. ctx().currentState.
+ * On the AVR there is exactly one context at a fixed address, so every
+ * access compiles to the same direct load or store as a plain global. The
+ * native build keeps a current-context pointer per thread, so a host
+ * program can hold any number of independent systems and run one on a
+ * thread by selecting its context (and its NativeBoard); a thread that
+ * selects nothing gets a context of its own.
+ *
+ * Module sources include this header after their own headers; module
+ * headers only define their state types. The memory monitor is the one
+ * exception: it measures the real AVR stack, so its state stays global.
+ */
+
+ #ifndef SYSTEM_CONTEXT_H
+ #define SYSTEM_CONTEXT_H
+
+ #include "system_config.h"
+ #include "interrupts.h"
+ #include "sensors.h"
+ #include "state_machine.h"
+ #include "isr_shared.h"
+ #include "critical_path.h"
+ #include "transition_audit.h"
+ #include "sampling_policy.h"
+ #include "report_queue.h"
+
+ struct SystemContext {
+   // State machine
+   SystemState currentState = IDLE;
+   SystemState previousState = IDLE;
+   SystemState pendingState = IDLE;                // for state debouncing
+   unsigned long stateChangeTime = 0;              // when the pending change was requested
+   StateEvaluation stateEvaluation = {STATE_INPUT_ALL, false, 0, 0, 0};
+   TransitionAudit transitionAudit = {};
+
+   // Sensors and flags
+   SensorStates sensors = {false, true, false, false, 0, 0, 0, 0};
+   SystemFlags systemFlags = {false, false, false, 1, 0};
+   SensorWarnings sensorWarnings = {};
+   ChannelSchedule channelSchedules[ANALOG_CHANNEL_COUNT] = {};
+   SamplingTimers samplingTimers = {};
+
+   // Shared with the ISRs
+   volatile PortDebouncer inputPortB = {};
+   SeqLock isrLock = {};
+   volatile IsrPublished isrPublished = {};
+   IsrSnapshot isrSnapshot = {};
+   unsigned int isrSnapshotRetries = 0;
+   TimerEvents timerEvents = {};
+   CriticalPathStats criticalPath = {};
+
+   // Serial input and output
+   CommandInput commandInput = {};
+   ReportQueue reportQueue = {};
+   unsigned long lastSerialUpdate = 0;
+   int statusUpdateCounter = 0;
+ };
+
+ #if defined(__AVR__)
+
+ extern SystemContext systemContext;
+
+ inline SystemContext& ctx() {
+   return systemContext;
+ }
+
+ #else
+
+ // Used while no context is selected
+ inline thread_local SystemContext threadSystemContext;
+
+ // Selected with selectSystemContext(); nullptr goes back to the thread's own
+ inline thread_local SystemContext* activeSystemContext = nullptr;
+
+ inline SystemContext& ctx() {
+   return activeSystemContext ? *activeSystemContext : threadSystemContext;
+ }
+
+ inline void selectSystemContext(SystemContext* context) {
+   activeSystemContext = context;
+ }
+
+ #endif
+
+ #endif // SYSTEM_CONTEXT_H
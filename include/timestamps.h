@@ -0,0 +1,58 @@
+/*
+ * Timestamps header declares the 16-bit relative timestamps used in the
+ * packed sensor and flag state
+ *
+ * A Stamp16 is millis() in STAMP_UNIT_MS units truncated to 16 bits, so it
+ * spans about 4.6 hours before wrapping. Ages use modular subtraction and
+ * are right across a wrap as long as the true age is inside that span;
+ * saturateStamp(), run from the 1-second tick, pins older stamps at
+ * STAMP_MAX_AGE so they never alias.
+ */
+
+ #ifndef TIMESTAMPS_H
+ #define TIMESTAMPS_H
+
+ #include <Arduino.h>
+
+ typedef uint16_t Stamp16;
+
+ #define STAMP_SHIFT 8                        // 256 ms per unit
+ #define STAMP_UNIT_MS (1UL << STAMP_SHIFT)
+ #define STAMP_MAX_AGE 0x8000                 // units, about 2.3 hours
+
+ inline Stamp16 stampNow() {
+   return (Stamp16)(millis() >> STAMP_SHIFT);
+ }
+
+ // Age in STAMP_UNIT_MS units
+ inline uint16_t stampAge(Stamp16 stamp) {
+   return (uint16_t)(stampNow() - stamp);
+ }
+
+ inline unsigned long stampElapsedMs(Stamp16 stamp) {
+   return (unsigned long)stampAge(stamp) << STAMP_SHIFT;
+ }
+
+ // Rollover-safe "more than intervalMs ago"
+ inline bool stampExpired(Stamp16 stamp, unsigned long intervalMs) {
+   return stampElapsedMs(stamp) > intervalMs;
+ }
+
+ // Milliseconds until stampExpired(stamp, intervalMs) turns true, 0 if it already is
+ inline unsigned long stampMsUntilExpired(Stamp16 stamp, unsigned long intervalMs) {
+   unsigned long needed = (intervalMs >> STAMP_SHIFT) + 1;
+   uint16_t age = stampAge(stamp);
+   if (age >= needed) return 0;
+   return ((needed - age) << STAMP_SHIFT) - (millis() & ((1UL << STAMP_SHIFT) - 1));
+ }
+
+ // True once the stamp has been pinned, i.e. its age is only a lower bound
+ inline bool stampSaturated(Stamp16 stamp) {
+   return stampAge(stamp) >= STAMP_MAX_AGE;
+ }
+
+ inline void saturateStamp(Stamp16& stamp) {
+   if (stampAge(stamp) > STAMP_MAX_AGE) stamp = stampNow() - STAMP_MAX_AGE;
+ }
+
+ #endif // TIMESTAMPS_H
@@ -0,0 +1,46 @@
+/*
+ * Transition Audit header declares the state transition history and
+ * time-in-state accounting
+ */
+
+ #ifndef TRANSITION_AUDIT_H
+ #define TRANSITION_AUDIT_H
+
+ #include "system_config.h"
+
+ #define TRANSITION_LOG_SIZE 8
+
+ // One committed transition
+ struct TransitionRecord {
+   unsigned long timestamp;     // millis() at commit
+   uint8_t from;                // SystemState
+   uint8_t to;                  // SystemState
+   uint8_t triggers;            // TRIGGER_* mask at commit
+   uint16_t debounceWait;       // ms the change was pending before commit
+ };
+
+ // Transition history ring and cumulative statistics
+ struct TransitionAudit {
+   TransitionRecord log[TRANSITION_LOG_SIZE];
+   uint8_t head;                              // next slot to write
+   uint8_t count;                             // valid records in log
+   unsigned long stateEnteredAt;
+   unsigned long residency[STATE_COUNT];      // ms spent in completed visits
+   uint16_t edgeCount[STATE_COUNT][STATE_COUNT];
+   uint16_t cancelled[STATE_COUNT];           // abandoned pending changes, by target
+   unsigned long total;
+   TransitionRecord reported;                 // record being written by the TRANSITIONS report
+   bool reportedValid;
+ };
+ #if defined(__AVR__)
+ // 9-byte records: the ring is 72 of the 150 bytes allowed on the Uno
+ static_assert(sizeof(TransitionAudit) <= 150, "TransitionAudit exceeds its 150-byte SRAM budget");
+ #endif
+
+ void recordTransition(SystemState from, SystemState to, uint8_t triggers, unsigned long debounceWait);
+ void recordCancelledTransition(SystemState target);
+ unsigned long getStateResidency(SystemState state);
+ unsigned long getTimeInState();
+ void printTransitionReport();
+
+ #endif // TRANSITION_AUDIT_H
@@ -7,7 +7,7 @@
  
  #include "system_config.h"
  
- String stateToString(SystemState state);
+ const __FlashStringHelper* stateToString(SystemState state);
  void printSystemStatus();
  void periodicStatusUpdate();
  
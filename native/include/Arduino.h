@@ -0,0 +1,156 @@
+/*
+ * Native Arduino shim provides the subset of the Arduino core used by the
+ * firmware modules so they can be compiled and exercised on a Linux host.
+ * Pins, clock and Serial belong to a NativeBoard. Each thread starts on its
+ * own board, and a host running many instances selects theirs with
+ * nativeSelectBoard(); time only advances when the host program advances it.
+ */
+
+ #ifndef NATIVE_ARDUINO_H
+ #define NATIVE_ARDUINO_H
+
+ #include <stdint.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <math.h>
+ #include <string>
+ #include <avr/pgmspace.h>
+
+ typedef uint8_t byte;
+ typedef bool boolean;
+
+ #define HIGH 0x1
+ #define LOW  0x0
+
+ #define INPUT 0x0
+ #define OUTPUT 0x1
+ #define INPUT_PULLUP 0x2
+
+ #define A0 14
+ #define A1 15
+ #define A2 16
+ #define A3 17
+ #define A4 18
+ #define A5 19
+
+ #define NATIVE_PIN_COUNT 20
+
+ #ifndef F_CPU
+ #define F_CPU 16000000L
+ #endif
+
+ #define DEC 10
+ #define HEX 16
+
+ // Digital and analog I/O
+ void pinMode(uint8_t pin, uint8_t mode);
+ void digitalWrite(uint8_t pin, uint8_t value);
+ int digitalRead(uint8_t pin);
+ int analogRead(uint8_t pin);
+
+ // Uno port mapping, for the pins the firmware reads as a port (D8-D13 on port B)
+ #define digitalPinToBitMask(pin) ((pin) >= 8 && (pin) <= 13 ? (uint8_t)(1 << ((pin) - 8)) : (uint8_t)0)
+ uint8_t nativeReadPortB();
+ #define PINB (nativeReadPortB())
+
+ // Time
+ unsigned long millis();
+ unsigned long micros();
+ void delay(unsigned long ms);
+ void delayMicroseconds(unsigned int us);
+
+ // Host-side control of the simulated hardware (selected board only)
+ void nativeSetDigitalInput(uint8_t pin, bool level);
+ bool nativeGetDigitalOutput(uint8_t pin);
+ void nativeSetAnalogInput(uint8_t pin, int value);
+ void nativeAdvanceMicros(unsigned long us);
+ void nativeSetMicros(unsigned long us);
+ void nativeResetHardware();          // selected board back to its power-on state
+
+ class __FlashStringHelper;
+ #define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+ /*
+  * Print base class mirroring the Arduino core formatting rules
+  */
+ class Print {
+   public:
+     virtual ~Print() {}
+     virtual size_t write(uint8_t c) = 0;
+     virtual size_t write(const uint8_t *data, size_t size);
+     virtual int availableForWrite() { return 0; }
+     size_t write(const char *str) { return str ? write(reinterpret_cast<const uint8_t *>(str), strlen(str)) : 0; }
+
+     size_t print(const __FlashStringHelper *str);
+     size_t print(const char *str);
+     size_t print(char c);
+     size_t print(unsigned char value, int base = DEC);
+     size_t print(int value, int base = DEC);
+     size_t print(unsigned int value, int base = DEC);
+     size_t print(long value, int base = DEC);
+     size_t print(unsigned long value, int base = DEC);
+     size_t print(double value, int digits = 2);
+
+     size_t println();
+     template <typename T> size_t println(const T &value) { size_t n = print(value); return n + println(); }
+     template <typename T> size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+
+   private:
+     size_t printNumber(unsigned long value, uint8_t base);
+     size_t printFloat(double value, uint8_t digits);
+ };
+
+ /*
+  * Host serial port: output goes to stdout unless muted, input is injected.
+  * Transmission is modelled against the virtual clock like the Uno's
+  * 64-byte TX ring: availableForWrite() reports the free space and a write
+  * into a full buffer stalls the clock until a byte has gone out. Serial
+  * holds no state of its own; it drives the port of the selected board
+  */
+ class HardwareSerial : public Print {
+   public:
+     void begin(unsigned long baud);
+     void flush();
+     int available();
+     int read();
+     int peek();
+     int availableForWrite() override;
+     size_t write(uint8_t c) override;
+     size_t write(const uint8_t *data, size_t size) override;
+     using Print::write;
+
+     // Host-side helpers
+     void inject(const char *text);
+     void setMuted(bool muted);
+     unsigned long bytesWritten() const;
+ };
+
+ extern HardwareSerial Serial;
+
+ // State of one board's serial port
+ struct NativeSerialPort {
+   std::string rxBuffer;
+   bool outputMuted = false;
+   unsigned long totalWritten = 0;
+   unsigned long microsPerByte = 0;   // 0 until begin(): output is instant
+   unsigned long txIdleAt = 0;        // virtual micros() when the TX buffer empties
+ };
+
+ /*
+  * One simulated Uno: everything the firmware can observe through the shim
+  */
+ struct NativeBoard {
+   uint8_t pinLevels[NATIVE_PIN_COUNT] = {};
+   int analogLevels[NATIVE_PIN_COUNT] = {};
+   unsigned long microsNow = 0;
+   NativeSerialPort serial;
+ };
+
+ // The calling thread's board; nullptr goes back to the thread's own
+ void nativeSelectBoard(NativeBoard *board);
+ NativeBoard &nativeBoard();
+
+ void setup();
+ void loop();
+
+ #endif // NATIVE_ARDUINO_H
@@ -0,0 +1,39 @@
+/*
+ * Native interrupt shim: ISRs become plain functions the host can call,
+ * and the peripheral registers touched by the firmware become per-thread
+ * variables
+ */
+
+ #ifndef NATIVE_AVR_INTERRUPT_H
+ #define NATIVE_AVR_INTERRUPT_H
+
+ #include <stdint.h>
+
+ #define ISR(vector) extern "C" void vector(void)
+
+ extern "C" void PCINT0_vect(void);
+ extern "C" void TIMER1_COMPA_vect(void);
+
+ inline void cli() {}
+ inline void sei() {}
+
+ // Pin change interrupt registers
+ extern thread_local volatile uint8_t PCICR;
+ extern thread_local volatile uint8_t PCMSK0;
+ #define PCIE0 0
+ #define PCINT0 0
+ #define PCINT1 1
+
+ // Timer1 registers
+ extern thread_local volatile uint8_t TCCR1A;
+ extern thread_local volatile uint8_t TCCR1B;
+ extern thread_local volatile uint16_t TCNT1;
+ extern thread_local volatile uint16_t OCR1A;
+ extern thread_local volatile uint8_t TIMSK1;
+ #define WGM12 3
+ #define CS10 0
+ #define CS11 1
+ #define CS12 2
+ #define OCIE1A 1
+
+ #endif // NATIVE_AVR_INTERRUPT_H
@@ -0,0 +1,26 @@
+/*
+ * Native pgmspace shim: flash and RAM share one address space on the host
+ */
+
+ #ifndef NATIVE_AVR_PGMSPACE_H
+ #define NATIVE_AVR_PGMSPACE_H
+
+ #include <stdint.h>
+ #include <string.h>
+
+ #define PROGMEM
+ #define PGM_P const char *
+ #define PSTR(s) (s)
+
+ #define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t *>(addr))
+ #define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+ #define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t *>(addr))
+ #define pgm_read_ptr(addr) (*reinterpret_cast<const void * const *>(addr))
+
+ #define strcmp_P(a, b) strcmp((a), (b))
+ #define strncmp_P(a, b, n) strncmp((a), (b), (n))
+ #define strlen_P(s) strlen(s)
+ #define strcpy_P(dst, src) strcpy((dst), (src))
+ #define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+ #endif // NATIVE_AVR_PGMSPACE_H
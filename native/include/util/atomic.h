@@ -0,0 +1,16 @@
+/*
+ * Native atomic block shim: the host has no interrupts to mask, so
+ * ATOMIC_BLOCK runs its body exactly once
+ */
+
+ #ifndef NATIVE_UTIL_ATOMIC_H
+ #define NATIVE_UTIL_ATOMIC_H
+
+ #include <stdint.h>
+
+ #define ATOMIC_RESTORESTATE 0
+ #define ATOMIC_FORCEON 1
+
+ #define ATOMIC_BLOCK(type) for (uint8_t atomicPass_ = ((void)(type), 1); atomicPass_; atomicPass_ = 0)
+
+ #endif // NATIVE_UTIL_ATOMIC_H
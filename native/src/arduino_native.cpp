@@ -0,0 +1,236 @@
+/*
+ * Native Arduino shim implementation
+ * Every host thread behaves like its own board until it selects another
+ */
+
+ #include <Arduino.h>
+ #include <avr/interrupt.h>
+ #include <stdio.h>
+
+ // Peripheral registers: written by setup(), never read back
+ thread_local volatile uint8_t PCICR = 0;
+ thread_local volatile uint8_t PCMSK0 = 0;
+ thread_local volatile uint8_t TCCR1A = 0;
+ thread_local volatile uint8_t TCCR1B = 0;
+ thread_local volatile uint16_t TCNT1 = 0;
+ thread_local volatile uint16_t OCR1A = 0;
+ thread_local volatile uint8_t TIMSK1 = 0;
+
+ /*
+  * Board selection
+  */
+ static thread_local NativeBoard threadBoard;
+ static thread_local NativeBoard *selectedBoard = nullptr;
+
+ void nativeSelectBoard(NativeBoard *board) { selectedBoard = board; }
+
+ NativeBoard &nativeBoard() { return selectedBoard ? *selectedBoard : threadBoard; }
+
+ /*
+  * Digital and analog I/O
+  */
+ void pinMode(uint8_t pin, uint8_t mode) {
+   if (pin < NATIVE_PIN_COUNT && mode == INPUT_PULLUP) nativeBoard().pinLevels[pin] = HIGH;
+ }
+
+ void digitalWrite(uint8_t pin, uint8_t value) {
+   if (pin < NATIVE_PIN_COUNT) nativeBoard().pinLevels[pin] = value ? HIGH : LOW;
+ }
+
+ int digitalRead(uint8_t pin) {
+   return pin < NATIVE_PIN_COUNT ? nativeBoard().pinLevels[pin] : LOW;
+ }
+
+ int analogRead(uint8_t pin) {
+   return pin < NATIVE_PIN_COUNT ? nativeBoard().analogLevels[pin] : 0;
+ }
+
+ uint8_t nativeReadPortB() {
+   const NativeBoard &board = nativeBoard();
+   uint8_t port = 0;
+   for (uint8_t pin = 8; pin <= 13; pin++) {
+     if (board.pinLevels[pin]) port |= digitalPinToBitMask(pin);
+   }
+   return port;
+ }
+
+ void nativeSetDigitalInput(uint8_t pin, bool level) {
+   digitalWrite(pin, level);
+ }
+
+ bool nativeGetDigitalOutput(uint8_t pin) {
+   return digitalRead(pin) == HIGH;
+ }
+
+ void nativeSetAnalogInput(uint8_t pin, int value) {
+   if (pin < NATIVE_PIN_COUNT) nativeBoard().analogLevels[pin] = value;
+ }
+
+ /*
+  * Virtual time
+  */
+ unsigned long millis() { return nativeBoard().microsNow / 1000; }
+ unsigned long micros() { return nativeBoard().microsNow; }
+ void delay(unsigned long ms) { nativeBoard().microsNow += ms * 1000; }
+ void delayMicroseconds(unsigned int us) { nativeBoard().microsNow += us; }
+ void nativeAdvanceMicros(unsigned long us) { nativeBoard().microsNow += us; }
+ void nativeSetMicros(unsigned long us) { nativeBoard().microsNow = us; }
+
+ void nativeResetHardware() {
+   nativeBoard() = NativeBoard();
+ }
+
+ /*
+  * Print
+  */
+ static std::string formatInteger(unsigned long value, bool negative, unsigned char base) {
+   char buf[8 * sizeof(long) + 2];
+   char *p = &buf[sizeof(buf) - 1];
+   *p = '\0';
+   if (base < 2) base = 10;
+   do {
+     unsigned digit = value % base;
+     *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+     value /= base;
+   } while (value);
+   if (negative) *--p = '-';
+   return std::string(p);
+ }
+
+ size_t Print::write(const uint8_t *data, size_t size) {
+   size_t n = 0;
+   while (size--) n += write(*data++);
+   return n;
+ }
+
+ size_t Print::print(const __FlashStringHelper *str) { return write(reinterpret_cast<const char *>(str)); }
+ size_t Print::print(const char *str) { return write(str); }
+ size_t Print::print(char c) { return write(static_cast<uint8_t>(c)); }
+ size_t Print::print(unsigned char value, int base) { return print(static_cast<unsigned long>(value), base); }
+ size_t Print::print(int value, int base) { return print(static_cast<long>(value), base); }
+ size_t Print::print(unsigned int value, int base) { return print(static_cast<unsigned long>(value), base); }
+
+ size_t Print::print(long value, int base) {
+   if (base == DEC && value < 0) {
+     size_t n = print('-');
+     return n + printNumber(-static_cast<unsigned long>(value), DEC);
+   }
+   return printNumber(static_cast<unsigned long>(value), base);
+ }
+
+ size_t Print::print(unsigned long value, int base) { return printNumber(value, base); }
+ size_t Print::print(double value, int digits) { return printFloat(value, digits); }
+ size_t Print::println() { return write("\r\n"); }
+
+ size_t Print::printNumber(unsigned long value, uint8_t base) {
+   return write(formatInteger(value, false, base).c_str());
+ }
+
+ // Same algorithm as the AVR core so output matches byte for byte
+ size_t Print::printFloat(double number, uint8_t digits) {
+   if (isnan(number)) return print("nan");
+   if (isinf(number)) return print("inf");
+   if (number > 4294967040.0) return print("ovf");
+   if (number < -4294967040.0) return print("ovf");
+
+   size_t n = 0;
+   if (number < 0.0) {
+     n += print('-');
+     number = -number;
+   }
+
+   double rounding = 0.5;
+   for (uint8_t i = 0; i < digits; ++i) rounding /= 10.0;
+   number += rounding;
+
+   unsigned long intPart = static_cast<unsigned long>(number);
+   double remainder = number - static_cast<double>(intPart);
+   n += print(intPart);
+
+   if (digits > 0) n += print('.');
+   while (digits-- > 0) {
+     remainder *= 10.0;
+     unsigned int toPrint = static_cast<unsigned int>(remainder);
+     n += print(toPrint);
+     remainder -= toPrint;
+   }
+   return n;
+ }
+
+ /*
+  * HardwareSerial
+  */
+ HardwareSerial Serial;
+
+ #define NATIVE_TX_BUFFER_SIZE 64
+
+ int HardwareSerial::available() { return static_cast<int>(nativeBoard().serial.rxBuffer.size()); }
+
+ int HardwareSerial::read() {
+   std::string &rx = nativeBoard().serial.rxBuffer;
+   if (rx.empty()) return -1;
+   int c = static_cast<unsigned char>(rx[0]);
+   rx.erase(0, 1);
+   return c;
+ }
+
+ int HardwareSerial::peek() {
+   const std::string &rx = nativeBoard().serial.rxBuffer;
+   return rx.empty() ? -1 : static_cast<unsigned char>(rx[0]);
+ }
+
+ void HardwareSerial::begin(unsigned long baud) {
+   NativeBoard &board = nativeBoard();
+   board.serial.microsPerByte = baud ? 10000000UL / baud : 0; // 8N1: 10 bits per byte
+   board.serial.txIdleAt = board.microsNow;
+ }
+
+ static unsigned int txQueued(const NativeBoard &board) {
+   const NativeSerialPort &port = board.serial;
+   if (port.microsPerByte == 0 || (long)(port.txIdleAt - board.microsNow) <= 0) return 0;
+   return (port.txIdleAt - board.microsNow + port.microsPerByte - 1) / port.microsPerByte;
+ }
+
+ int HardwareSerial::availableForWrite() {
+   return NATIVE_TX_BUFFER_SIZE - 1 - txQueued(nativeBoard());
+ }
+
+ /*
+  * Account for one byte entering the TX buffer, stalling while it is full
+  */
+ static void txByte(NativeBoard &board) {
+   NativeSerialPort &port = board.serial;
+   if (port.microsPerByte == 0) return;
+   if (txQueued(board) >= NATIVE_TX_BUFFER_SIZE - 1) {
+     board.microsNow = port.txIdleAt - (NATIVE_TX_BUFFER_SIZE - 2) * port.microsPerByte;
+   }
+   if ((long)(port.txIdleAt - board.microsNow) < 0) port.txIdleAt = board.microsNow;
+   port.txIdleAt += port.microsPerByte;
+ }
+
+ size_t HardwareSerial::write(uint8_t c) {
+   NativeBoard &board = nativeBoard();
+   txByte(board);
+   board.serial.totalWritten++;
+   if (!board.serial.outputMuted) fputc(c, stdout);
+   return 1;
+ }
+
+ size_t HardwareSerial::write(const uint8_t *data, size_t size) {
+   NativeBoard &board = nativeBoard();
+   for (size_t i = 0; i < size; i++) txByte(board);
+   board.serial.totalWritten += size;
+   if (!board.serial.outputMuted) fwrite(data, 1, size, stdout);
+   return size;
+ }
+
+ void HardwareSerial::flush() {
+   NativeBoard &board = nativeBoard();
+   const NativeSerialPort &port = board.serial;
+   if (port.microsPerByte && (long)(port.txIdleAt - board.microsNow) > 0) board.microsNow = port.txIdleAt;
+   if (!port.outputMuted) fflush(stdout);
+ }
+
+ void HardwareSerial::inject(const char *text) { nativeBoard().serial.rxBuffer += text; }
+ void HardwareSerial::setMuted(bool muted) { nativeBoard().serial.outputMuted = muted; }
+ unsigned long HardwareSerial::bytesWritten() const { return nativeBoard().serial.totalWritten; }
@@ -3,32 +3,36 @@
  */
 
  #include "actuators.h"
+ #include "critical_path.h"
+ #include "system_context.h"
+ #include <util/atomic.h>
 
  /*
   * Update all system outputs based on current state
   * Separates actuation logic from state logic
   */
  void updateSystemOutputs() {
-   // Status LED handled in timer interrupt
+   // Status LED handled in processTimerEvents()
    
-   // Alarm LED
-   switch (currentState) {
-     case IDLE:
-     case MONITORING:
-       digitalWrite(ALARM_LED_PIN, LOW);
-       break;
-     case ALERT:
-       // Handled in timer for blinking
-       break;
-     case ALARM:
-       digitalWrite(ALARM_LED_PIN, HIGH);
-       break;
-   }
+   // Levels come from loop-owned state, so they are worked out unmasked.
+   // The alarm LED blinks from the timer path during ALERT
+   bool driveAlarmLed = ctx().currentState != ALERT;
+   uint8_t alarmLed = ctx().currentState == ALARM ? HIGH : LOW;
+   uint8_t buzzer = (ctx().systemFlags.alarmActive && ctx().currentState == ALARM) ? HIGH : LOW;
+   
+   // Nothing to change: no need to mask. Safe without it, since a latch
+   // taken after this check only ever drives the pins further from idle
+   if (digitalRead(BUZZER_PIN) == buzzer && (!driveAlarmLed || digitalRead(ALARM_LED_PIN) == alarmLed)) return;
    
-   // Buzzer
-   if (systemFlags.alarmActive && currentState == ALARM) {
-     digitalWrite(BUZZER_PIN, HIGH);
-   } else {
-     digitalWrite(BUZZER_PIN, LOW);
+   // The critical fast path owns the alarm outputs until ALARM is committed.
+   // Masked only for the check and the writes, so the PCINT ISR cannot
+   // latch in between
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+     unsigned long maskedAt = micros();
+     if (!criticalPathLatched()) {
+       if (driveAlarmLed) digitalWrite(ALARM_LED_PIN, alarmLed);
+       digitalWrite(BUZZER_PIN, buzzer);
+     }
+     noteMaskedWindow(maskedAt);
    }
- }
\ No newline at end of file
+ }
@@ -0,0 +1,158 @@
+/*
+ * Critical Path implementation
+ * A critical trigger combination (CRITICAL_TRIGGERS, motion plus gas danger
+ * by default) skips the MONITORING -> ALERT -> ALARM debounce chain. The
+ * PCINT ISR drives the buzzer and alarm LED itself, so the edge-to-buzzer
+ * bound is the ISR's own latency and does not depend on how long the main
+ * loop takes; the loop then commits the ALARM state on its next pass.
+ *
+ * Requiring two independent inputs at once is what guards against noise
+ * here, in place of the time-based debounce.
+ *
+ * Latencies are timed from ISR entry. An edge that arrives while
+ * interrupts are masked (another ISR, or an ATOMIC_BLOCK in the loop)
+ * waits for the mask to lift first, so the worst edge-to-buzzer time is
+ * the reported maximum plus the longest masked window, tracked alongside.
+ */
+
+ #include "critical_path.h"
+ #include "state_machine.h"
+ #include "report_queue.h"
+ #include "isr_shared.h"
+ #include "system_context.h"
+
+ // Only the digital inputs can be evaluated from the ISR
+ #define ISR_VISIBLE_TRIGGERS (TRIGGER_MOTION | TRIGGER_GAS_DANGER)
+
+ /*
+  * Called from ISR(PCINT0_vect) with freshly read pin levels
+  */
+ void checkCriticalFastPath(bool pir, bool gasSafe, unsigned long edgeMicros) {
+   if (!CRITICAL_FAST_PATH_ENABLED || !ctx().criticalPath.armed) return;
+   if (CRITICAL_TRIGGERS == 0 || (CRITICAL_TRIGGERS & ~ISR_VISIBLE_TRIGGERS)) return;
+   if (criticalPathLatched()) return;
+
+   uint8_t triggers = 0;
+   if (pir) triggers |= TRIGGER_MOTION;
+   if (!gasSafe) triggers |= TRIGGER_GAS_DANGER;
+   if ((triggers & CRITICAL_TRIGGERS) != CRITICAL_TRIGGERS) return;
+
+   digitalWrite(BUZZER_PIN, HIGH);
+   digitalWrite(ALARM_LED_PIN, HIGH);
+   unsigned int buzzerLatency = micros() - edgeMicros;
+   
+   seqWriteBegin(ctx().isrLock);
+   ctx().isrPublished.fastPathEdgeMicros = edgeMicros;
+   ctx().isrPublished.fastPathBuzzerLatency = buzzerLatency;
+   ctx().isrPublished.fastPathLatches = ctx().isrPublished.fastPathLatches + 1;
+   seqWriteEnd(ctx().isrLock);
+ }
+
+ /*
+  * True from the ISR sounding the alarm until the loop commits or drops it.
+  * Reads the live count, not the snapshot, so the loop never drives the
+  * alarm outputs back over a latch taken since the pass started
+  */
+ bool criticalPathLatched() {
+   return ctx().isrPublished.fastPathLatches != ctx().criticalPath.committedLatches;
+ }
+
+ /*
+  * Tell the ISR whether the fast path may fire; called wherever armed or
+  * currentState changes. One byte, so the ISR never sees half a write
+  */
+ void publishCriticalArming() {
+   ctx().criticalPath.armed = ctx().systemFlags.armed && ctx().currentState != ALARM;
+ }
+
+ /*
+  * Commit the ALARM state for a latched fast-path edge, bypassing
+  * getStateDebounceTime(). Called at the start of every state machine pass
+  */
+ void commitCriticalAlarm() {
+   if (ctx().isrSnapshot.fastPathLatches == ctx().criticalPath.committedLatches) return;
+
+   // Taken from this pass's snapshot, so the pair cannot tear
+   unsigned long edgeMicros = ctx().isrSnapshot.fastPathEdgeMicros;
+   unsigned int buzzerLatency = ctx().isrSnapshot.fastPathBuzzerLatency;
+
+   // Disarmed (or already alarming) before the loop got here: drop the latch
+   if (!ctx().systemFlags.armed || ctx().currentState == ALARM) {
+     ctx().criticalPath.committedLatches = ctx().isrSnapshot.fastPathLatches;
+     return;
+   }
+
+   // Committed from the latch alone: the sensor levels stay with the
+   // debouncer, so a glitch that latched the alarm cannot stick in them
+   LOG_MINIMAL(F("ALERT: Critical trigger - fast path to ALARM"));
+   executeStateTransition(ALARM, CRITICAL_TRIGGERS);
+   ctx().pendingState = ctx().currentState;
+
+   unsigned long commitLatency = micros() - edgeMicros;
+   ctx().criticalPath.lastBuzzerLatency = buzzerLatency;
+   ctx().criticalPath.lastCommitLatency = commitLatency;
+   if (buzzerLatency > ctx().criticalPath.maxBuzzerLatency) ctx().criticalPath.maxBuzzerLatency = buzzerLatency;
+   if (commitLatency > ctx().criticalPath.maxCommitLatency) ctx().criticalPath.maxCommitLatency = commitLatency;
+   ctx().criticalPath.activations++;
+   ctx().criticalPath.committedLatches = ctx().isrSnapshot.fastPathLatches;
+ }
+
+ /*
+  * Record how long interrupts have been masked since startMicros. Call at
+  * the end of an ISR or an ATOMIC_BLOCK body, before the mask lifts
+  */
+ void noteMaskedWindow(unsigned long startMicros) {
+   unsigned int window = micros() - startMicros;
+   if (window > ctx().criticalPath.maxMaskedWindow) ctx().criticalPath.maxMaskedWindow = window;
+ }
+
+ /*
+  * Fast-path statistics, one line per step
+  */
+ static bool latencyReportStep(uint8_t step, ReportWriter& out) {
+   switch (step) {
+     case 0:
+       out << F("\n=== CRITICAL FAST PATH ===") << eol;
+       break;
+     case 1:
+       out << F("Enabled: ") << (CRITICAL_FAST_PATH_ENABLED ? F("YES") : F("NO"))
+           << F(" (triggers: ") << triggerNames(CRITICAL_TRIGGERS) << ')' << eol;
+       break;
+     case 2:
+       out << F("Activations: ") << ctx().criticalPath.activations << eol;
+       break;
+     case 3:
+       if (ctx().criticalPath.activations > 0) {
+         out << F("Edge to Buzzer: last ") << ctx().criticalPath.lastBuzzerLatency
+             << F("us, max ") << ctx().criticalPath.maxBuzzerLatency << F("us") << eol;
+       }
+       break;
+     case 4:
+       if (ctx().criticalPath.activations > 0) {
+         out << F("Edge to ALARM State: last ") << ctx().criticalPath.lastCommitLatency
+             << F("us, max ") << ctx().criticalPath.maxCommitLatency << F("us") << eol;
+       }
+       break;
+     case 5: {
+       unsigned int window;
+       ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+         window = ctx().criticalPath.maxMaskedWindow;
+       }
+       out << F("Longest Masked Window: ") << window << F("us") << eol;
+       break;
+     }
+     case 6:
+       out << F("==========================\n") << eol;
+       break;
+     default:
+       return false;
+   }
+   return true;
+ }
+
+ /*
+  * Queue the LATENCY report
+  */
+ void printLatencyReport() {
+   queueReport(latencyReportStep);
+ }
@@ -4,36 +4,51 @@
 
  #include "interrupts.h"
  #include "state_machine.h"
+ #include "critical_path.h"
+ #include "sampling_policy.h"
+ #include "isr_shared.h"
+ #include "system_context.h"
 
+ // Port B bits of the debounced inputs, from digitalPinToBitMask()
+ static const uint8_t pirInputMask = digitalPinToBitMask(PIR_SENSOR_PIN);
+ static const uint8_t gasInputMask = digitalPinToBitMask(GAS_D_PIN);
+ 
  /*
   * Pin Change Interrupt Service Routine
   * Handles PCI for pins D8-D13 (PCINT0-PCINT5)
-  * Sets flags for main loop processing
+  * Only serves the critical alarm fast path; regular sensor changes are
+  * debounced from the Timer1 samples
   */
  ISR(PCINT0_vect) {
-   // Set flag for main loop to handle
-   pciTriggered = true;
+   unsigned long edgeMicros = micros();
    
    // Read current pin states (quick operation)
    bool currentPIR = digitalRead(PIR_SENSOR_PIN);
    bool currentGas = digitalRead(GAS_D_PIN);
    
-   // Set specific flags if state changed
-   if (currentPIR != sensors.pir) {
-     pirChange = true;
-   }
-   if (currentGas != sensors.gasSafe) {
-     gasChange = true;
-   }
+   checkCriticalFastPath(currentPIR, currentGas, edgeMicros);
  }
  
  /*
   * Timer1 Compare Match Interrupt Service Routine
-  * Executes every 1 second for periodic tasks
+  * Executes INPUT_SAMPLE_HZ times per second: samples port B into the
+  * debouncer, counts down the analog sampling schedules, and publishes the
+  * 1-second tick for periodic tasks
   */
  ISR(TIMER1_COMPA_vect) {
-   timerTick = true;
-   systemFlags.statusLedState = !systemFlags.statusLedState;
+   unsigned long entryMicros = micros();
+   
+   seqWriteBegin(ctx().isrLock);
+   debouncePort(ctx().inputPortB, PINB);
+   if (++ctx().timerEvents.sampleTicks >= INPUT_SAMPLE_HZ) {
+     ctx().timerEvents.sampleTicks = 0;
+     ctx().isrPublished.secondTicks = ctx().isrPublished.secondTicks + 1;
+     ctx().isrPublished.statusLed = !ctx().isrPublished.statusLed;
+   }
+   seqWriteEnd(ctx().isrLock);
+   
+   samplingTick();
+   noteMaskedWindow(entryMicros);
  }
  
  /*
@@ -47,32 +62,35 @@
    // Enable specific pins: PCINT0 (D8) and PCINT1 (D9)
    PCMSK0 |= (1 << PCINT0) | (1 << PCINT1);
    
-   LOG_NORMAL("PCI configured for pins D8 (PCINT0) and D9 (PCINT1)");
+   LOG_NORMAL(F("PCI configured for pins D8 (PCINT0) and D9 (PCINT1)"));
  }
  
  /*
-  * Configure Timer1 for 1-second interrupts
+  * Configure Timer1 for INPUT_SAMPLE_HZ interrupts
   * Uses CTC mode with prescaler for accurate timing
   */
  void setupTimerInterrupt() {
    // Disable interrupts during setup
    cli();
    
+   // Debounced levels start from the current pin levels
+   initPortDebouncer(ctx().inputPortB, PINB);
+   
    // Clear Timer1 registers
    TCCR1A = 0;
    TCCR1B = 0;
    TCNT1 = 0;
    
-   // Set compare match value for 1 second interval
-   // 16MHz / 1024 prescaler = 15625 Hz
-   // For 1 second: 15625 - 1 = 15624
-   OCR1A = 15624;
+   // Set compare match value for the sample interval
+   // 16MHz / 64 prescaler = 250000 Hz
+   // For 80 Hz (12.5 ms): 3125 - 1 = 3124
+   OCR1A = F_CPU / 64 / INPUT_SAMPLE_HZ - 1;
    
    // Configure Timer1 for CTC mode
    TCCR1B |= (1 << WGM12);
    
-   // Set prescaler to 1024
-   TCCR1B |= (1 << CS12) | (1 << CS10);
+   // Set prescaler to 64
+   TCCR1B |= (1 << CS11) | (1 << CS10);
    
    // Enable Timer1 compare match interrupt
    TIMSK1 |= (1 << OCIE1A);
@@ -80,60 +98,54 @@
    // Re-enable interrupts
    sei();
    
-   LOG_NORMAL("Timer1 configured for 1-second intervals");
+   LOG_NORMAL(F("Timer1 configured for ") << INPUT_SAMPLE_HZ << F("Hz input sampling, ")
+              << DEBOUNCE_SAMPLES * 1000 / INPUT_SAMPLE_HZ << F("ms debounce"));
  }
  
  /*
-  * Process Pin Change Interrupt events
-  * Handles debouncing and state updates
+  * Process debounced input edges
+  * Applies the rise/fall masks in this pass's ISR snapshot to the sensor
+  * states, then acknowledges them to the Timer1 debouncer
   */
- void processPCIEvents() {
-   if (!pciTriggered) return;
+ void processInputEvents() {
+   uint8_t edges = ctx().isrSnapshot.inputRise | ctx().isrSnapshot.inputFall;
+   uint8_t levels = ctx().isrSnapshot.inputLevels;
    
-   unsigned long currentTime = millis();
-   bool stateChanged = false;
+   if (!edges) return;
+   ackInputEdges(ctx().isrSnapshot.inputRise, ctx().isrSnapshot.inputFall);
+   if (!(edges & (pirInputMask | gasInputMask))) return;
+   
+   Stamp16 currentTime = stampNow();
    
    // Handle motion sensor change
-   if (pirChange) {
-     if (currentTime - sensors.pirLastChange > DEBOUNCE_DELAY) {
-       sensors.pirPrevious = sensors.pir;
-       sensors.pir = digitalRead(PIR_SENSOR_PIN);
-       sensors.pirLastChange = currentTime;
-       stateChanged = true;
-       
-      // Only log significant changes or in verbose mode
-      if (systemFlags.verboseLogging || (sensors.pir && systemFlags.armed)) {
-        LOG_NORMAL("SENSOR: PIR detector = " + String(sensors.pir ? "ACTIVE" : "INACTIVE"));
-      }
-      
-      // Always log motion detection when armed
-      if (sensors.pir && systemFlags.armed && !systemFlags.verboseLogging) {
-        LOG_MINIMAL("ALERT: Motion detected");
-      }
+   if (edges & pirInputMask) {
+     ctx().sensors.pirPrevious = ctx().sensors.pir;
+     ctx().sensors.pir = (levels & pirInputMask) != 0;
+     ctx().sensors.pirLastChange = currentTime;
+     
+    // Only log significant changes or in verbose mode
+    if (ctx().systemFlags.verboseLogging || (ctx().sensors.pir && ctx().systemFlags.armed)) {
+      LOG_NORMAL(F("SENSOR: PIR detector = ") << (ctx().sensors.pir ? F("ACTIVE") : F("INACTIVE")));
+    }
+    
+    // Always log motion detection when armed
+    if (ctx().sensors.pir && ctx().systemFlags.armed && !ctx().systemFlags.verboseLogging) {
+      LOG_MINIMAL(F("ALERT: Motion detected"));
     }
-    pirChange = false;
   }
    
    // Handle gas change
-   if (gasChange) {
-     if (currentTime - sensors.gasLastChange > DEBOUNCE_DELAY) {
-       sensors.gasPrevious = sensors.gasSafe;
-       sensors.gasSafe = digitalRead(GAS_D_PIN);
-       sensors.gasLastChange = currentTime;
-       stateChanged = true;
-       
-       // Always log gas safety changes
-      LOG_MINIMAL("SENSOR: Gas sensor = " + String(sensors.gasSafe ? "SAFE" : "DANGER"));
-    }
-    gasChange = false;
+   if (edges & gasInputMask) {
+     ctx().sensors.gasPrevious = ctx().sensors.gasSafe;
+     ctx().sensors.gasSafe = (levels & gasInputMask) != 0;
+     ctx().sensors.gasLastChange = currentTime;
+     
+     // Always log gas safety changes
+    LOG_MINIMAL(F("SENSOR: Gas sensor = ") << (ctx().sensors.gasSafe ? F("SAFE") : F("DANGER")));
   }
    
-   pciTriggered = false;
-   
-   // Trigger state machine update if sensors changed
-   if (stateChanged) {
-    processStateMachine();
-  }
+   // Sensors changed: the state machine evaluates in this pass's THINK phase
+   markStateInputsDirty(STATE_INPUT_SENSOR);
  }
  
  /*
@@ -141,28 +153,32 @@
   * Handles periodic tasks triggered by Timer1 interrupt
   */
  void processTimerEvents() {
-   if (!timerTick) return;
+   // Analog channels fall due on their own Timer1 schedules
+   readAnalogSensors();
+   
+   // Ticks missed during a long pass are handled once
+   if (ctx().isrSnapshot.secondTicks == ctx().timerEvents.lastSecondTick) return;
+   ctx().timerEvents.lastSecondTick = ctx().isrSnapshot.secondTicks;
    
    // Update status LED
-   digitalWrite(STATUS_LED_PIN, systemFlags.statusLedState);
+   digitalWrite(STATUS_LED_PIN, ctx().isrSnapshot.statusLed);
    
-   // Read analog sensors
-   readAnalogSensors();
+   // Keep long-lived 16-bit stamps from wrapping
+   saturateStamp(ctx().sensors.pirLastChange);
+   saturateStamp(ctx().sensors.gasLastChange);
+   saturateStamp(ctx().systemFlags.alarmStartTime);
    
-  static int timerCounter = 0;
-  timerCounter++;
+  ctx().timerEvents.seconds++;
   
   // Log every 30 seconds in monitoring mode (every 10 seconds if verbose)
   bool shouldLog = false;
-  if (systemFlags.verboseLogging && (timerCounter % 10 == 0)) {
+  if (ctx().systemFlags.verboseLogging && (ctx().timerEvents.seconds % 10 == 0)) {
     shouldLog = true;
-  } else if (currentState == MONITORING && (timerCounter % 30 == 0)) {
+  } else if (ctx().currentState == MONITORING && (ctx().timerEvents.seconds % 30 == 0)) {
     shouldLog = true;
   }
   
   if (shouldLog) {
-    LOG_VERBOSE("TIMER: Periodic check - System operational");
+    LOG_VERBOSE(F("TIMER: Periodic check - System operational"));
   }
-   
-   timerTick = false;
  }
\ No newline at end of file
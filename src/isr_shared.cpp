@@ -0,0 +1,46 @@
+/*
+ * ISR Shared implementation
+ * takeIsrSnapshot() is the loop's only read of ISR-written data; the rest
+ * of the pass works from isrSnapshot
+ */
+
+ #include "isr_shared.h"
+ #include "critical_path.h"
+ #include "system_context.h"
+
+ /*
+  * Copy the ISR-published state for this pass, with interrupts left on
+  */
+ void takeIsrSnapshot() {
+   for (;;) {
+     uint8_t sequence = seqReadBegin(ctx().isrLock);
+     ctx().isrSnapshot.inputLevels = ctx().inputPortB.state;
+     ctx().isrSnapshot.inputRise = ctx().inputPortB.rise;
+     ctx().isrSnapshot.inputFall = ctx().inputPortB.fall;
+     ctx().isrSnapshot.secondTicks = ctx().isrPublished.secondTicks;
+     ctx().isrSnapshot.statusLed = ctx().isrPublished.statusLed;
+     ctx().isrSnapshot.fastPathLatches = ctx().isrPublished.fastPathLatches;
+     ctx().isrSnapshot.fastPathEdgeMicros = ctx().isrPublished.fastPathEdgeMicros;
+     ctx().isrSnapshot.fastPathBuzzerLatency = ctx().isrPublished.fastPathBuzzerLatency;
+     if (!seqReadRetry(ctx().isrLock, sequence)) return;
+     ctx().isrSnapshotRetries++;
+   }
+ }
+
+ /*
+  * Clear the debounced edges the loop has handled. The Timer1 ISR ORs new
+  * edges into the same bytes, so this is a read-modify-write it must not
+  * interleave with
+  */
+ void ackInputEdges(uint8_t rise, uint8_t fall) {
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+     unsigned long maskedAt = micros();
+     ctx().inputPortB.rise &= ~rise;
+     ctx().inputPortB.fall &= ~fall;
+     noteMaskedWindow(maskedAt);
+   }
+ }
+
+ unsigned int getIsrSnapshotRetries() {
+   return ctx().isrSnapshotRetries;
+ }
@@ -9,6 +9,9 @@
 #include "state_machine.h"
 #include "actuators.h"
 #include "utilities.h"
+#include "memory_monitor.h"
+#include "report_queue.h"
+#include "isr_shared.h"
  
 void setup() {
   systemInit();
@@ -16,16 +19,22 @@ void setup() {
  
 void loop() {
   // SENSE: Process all inputs
-  processPCIEvents();          // Event-based sensor processing
+  takeIsrSnapshot();           // One coherent copy of ISR-shared state
+  processInputEvents();        // Debounced sensor edges
   processSerialCommands();     // User commands
+  memoryCheckpoint(PHASE_SENSE);
    
   // THINK: Process state machine and coordination
   processStateMachine();       // Main state logic
   processTimerEvents();        // Time-based processing
+  memoryCheckpoint(PHASE_THINK);
    
   // ACT: Update all outputs
   updateSystemOutputs();       // Actuator control
+  memoryCheckpoint(PHASE_ACT);
    
   // MONITOR: Provide system feedback
   periodicStatusUpdate();      // Serial monitoring
+  serviceReports();            // Queued reports, as TX space allows
+  memoryCheckpoint(PHASE_MONITOR);
 }
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*
+ * Memory Monitor implementation
+ * Free SRAM is painted with STACK_CANARY before main() runs. The stack
+ * grows down into the painted gap and the heap grows up into it, so the
+ * bytes that are no longer canary show how close the two have come.
+ *
+ * Per-phase peaks: each memoryCheckpoint() finds the lowest byte written
+ * since the previous checkpoint, charges it to the phase that just ran,
+ * then repaints that span so the next phase is measured on its own.
+ *
+ * The gap's lower bound follows the highest __brkval seen at a checkpoint,
+ * so live heap is never counted as stack. Heap a block used and released
+ * between two checkpoints is not seen that way: if such residue sits next
+ * to a new stack low, the full scan charges it to the stack too.
+ */
+
+ #include "memory_monitor.h"
+
+ static const char phaseSetup[] PROGMEM = "SETUP";
+ static const char phaseSense[] PROGMEM = "SENSE";
+ static const char phaseThink[] PROGMEM = "THINK";
+ static const char phaseAct[] PROGMEM = "ACT";
+ static const char phaseMonitor[] PROGMEM = "MONITOR";
+ static const char* const phaseNames[PHASE_COUNT] PROGMEM = {
+   phaseSetup, phaseSense, phaseThink, phaseAct, phaseMonitor
+ };
+
+ static const __FlashStringHelper* phaseName(uint8_t phase) {
+   return (const __FlashStringHelper*)pgm_read_ptr(&phaseNames[phase]);
+ }
+
+ #if defined(__AVR__)
+
+ extern "C" {
+   extern uint8_t __heap_start;
+   extern char* __brkval;
+
+   // avr-libc malloc free list
+   struct __freelist {
+     size_t sz;
+     struct __freelist* nx;
+   };
+   extern struct __freelist* __flp;
+ }
+
+ #define MEMORY_STR(x) #x
+ #define MEMORY_XSTR(x) MEMORY_STR(x)
+
+ /*
+  * Paint everything from the end of .bss to RAMEND with the canary
+  * Runs from .init1, before the stack pointer is set up, so it must not
+  * use the stack or any C code
+  */
+ extern "C" void paintStack() __attribute__((naked, used, section(".init1")));
+ extern "C" void paintStack() {
+   __asm volatile (
+     "    ldi r30, lo8(__heap_start)\n"
+     "    ldi r31, hi8(__heap_start)\n"
+     "    ldi r24, " MEMORY_XSTR(STACK_CANARY) "\n"
+     "    ldi r25, hi8(__stack)\n"
+     "    rjmp 2f\n"
+     "1:  st Z+, r24\n"
+     "2:  cpi r30, lo8(__stack)\n"
+     "    cpc r31, r25\n"
+     "    brlo 1b\n"
+     "    breq 1b\n");
+ }
+
+ // Clean bytes required just below the deepest stack byte seen so far
+ // before a checkpoint trusts that the phase went no deeper. Larger than
+ // any frame's unwritten locals (the firmware keeps no local buffers)
+ #define STACK_SCAN_GUARD 64
+
+ static uint8_t* scanStart;           // lowest address of the painted gap
+ static uint8_t* stackLowest;         // deepest stack byte seen at any checkpoint
+ static uint8_t* heapTopMax;          // highest __brkval seen at any checkpoint
+ static unsigned int phasePeak[PHASE_COUNT];
+
+ static inline uint8_t* heapTop() {
+   return __brkval ? (uint8_t*)__brkval : &__heap_start;
+ }
+
+ /*
+  * Locate the gap left by startup: the longest canary run between the
+  * heap and the stack. Checkpoints scan upward from its lower end
+  */
+ void memoryMonitorInit() {
+   uint8_t* sp = (uint8_t*)SP;
+   uint8_t* runStart = heapTop();
+   uint8_t* bestStart = runStart;
+   unsigned int bestLength = 0;
+
+   for (uint8_t* p = heapTop(); p <= sp; p++) {
+     if (*p != STACK_CANARY) {
+       runStart = p + 1;
+     } else if ((unsigned int)(p - runStart + 1) > bestLength) {
+       bestLength = p - runStart + 1;
+       bestStart = runStart;
+     }
+   }
+
+   scanStart = bestStart;
+   stackLowest = (uint8_t*)RAMEND + 1;
+   heapTopMax = heapTop();
+   memoryCheckpoint(PHASE_SETUP);
+ }
+
+ /*
+  * Charge the stack depth reached since the last checkpoint to a phase
+  * and repaint it. Includes this function's own call overhead. Costs the
+  * distance from the all-time low to this phase's low, not the whole gap
+  */
+ void memoryCheckpoint(LoopPhase phase) {
+   uint8_t* sp = (uint8_t*)SP;
+   uint8_t* top = heapTop();
+
+   // Heap growth moves the bottom of the gap up; never scan live heap
+   if (top > heapTopMax) heapTopMax = top;
+   if (top > scanStart) scanStart = top;
+
+   // Usually the phase stayed above the all-time low: scan up from there
+   // instead of across the whole gap. A dirty guard means a new low
+   uint8_t* p = scanStart;
+   if (stackLowest <= sp && stackLowest - scanStart > STACK_SCAN_GUARD) {
+     uint8_t* q = stackLowest - STACK_SCAN_GUARD;
+     while (q < stackLowest && *q == STACK_CANARY) q++;
+     if (q == stackLowest) p = stackLowest;
+   }
+   while (p <= sp && *p == STACK_CANARY) p++;
+
+   unsigned int used = RAMEND - (unsigned int)p + 1;
+   if (used > phasePeak[phase]) phasePeak[phase] = used;
+   if (p < stackLowest) stackLowest = p;
+
+   // Repaint what this phase dirtied, up to (not including) our own frame
+   for (uint8_t* q = p; q <= sp; q++) {
+     *q = STACK_CANARY;
+   }
+ }
+
+ unsigned int getStackHighWaterMark() {
+   return RAMEND - (unsigned int)stackLowest + 1;
+ }
+
+ /*
+  * Highest heap byte ever written: the sampled __brkval peak, extended by
+  * any residue left above it by blocks freed between checkpoints
+  */
+ unsigned int getHeapHighWaterMark() {
+   uint8_t* p = heapTopMax;
+   while (p < scanStart && *p != STACK_CANARY) p++;
+   return (unsigned int)(p - &__heap_start);
+ }
+
+ unsigned int getFreeGap() {
+   return (unsigned int)((uint8_t*)SP - heapTop());
+ }
+
+ /*
+  * Largest allocation that could currently succeed: either a block on the
+  * malloc free list or the gap between the heap top and the stack
+  */
+ unsigned int getLargestFreeBlock() {
+   unsigned int largest = getFreeGap();
+   for (struct __freelist* fp = __flp; fp; fp = fp->nx) {
+     if (fp->sz > largest) largest = fp->sz;
+   }
+   return largest;
+ }
+
+ static unsigned int getFreeListTotal() {
+   unsigned int total = 0;
+   for (struct __freelist* fp = __flp; fp; fp = fp->nx) {
+     total += fp->sz;
+   }
+   return total;
+ }
+
+ unsigned int getPhaseStackPeak(LoopPhase phase) {
+   return phasePeak[phase];
+ }
+
+ #else
+
+ // Native build: there is no shared heap/stack region to instrument
+ void memoryMonitorInit() {}
+ void memoryCheckpoint(LoopPhase) {}
+ unsigned int getStackHighWaterMark() { return 0; }
+ unsigned int getHeapHighWaterMark() { return 0; }
+ unsigned int getFreeGap() { return 0; }
+ unsigned int getLargestFreeBlock() { return 0; }
+ static unsigned int getFreeListTotal() { return 0; }
+ unsigned int getPhaseStackPeak(LoopPhase) { return 0; }
+
+ #endif
+
+ /*
+  * Memory usage for the DEBUG report, one line per step
+  */
+ bool memoryReportStep(uint8_t step, ReportWriter& out) {
+   switch (step) {
+     case MEMORY_FREE:
+       out << F("Free RAM: ") << getFreeGap() << eol;
+       break;
+     case MEMORY_STACK:
+       out << F("Stack High Water: ") << getStackHighWaterMark() << F(" bytes") << eol;
+       break;
+     case MEMORY_HEAP:
+       out << F("Heap High Water: ") << getHeapHighWaterMark() << F(" bytes") << eol;
+       break;
+     case MEMORY_LARGEST:
+       out << F("Largest Free Block: ") << getLargestFreeBlock()
+           << F(" bytes (free list: ") << getFreeListTotal() << F(" bytes)") << eol;
+       break;
+     case MEMORY_MARGIN:
+ #if defined(__AVR__)
+       out << F("Collision Margin: ")
+           << (long)(RAMEND + 1 - (unsigned int)&__heap_start) - getStackHighWaterMark() - getHeapHighWaterMark()
+           << F(" bytes") << eol;
+ #endif
+       break;
+     case MEMORY_PHASES:
+       // Per-phase stack peaks; 61 characters at most with four-digit peaks
+       out << F("Stack:");
+       for (uint8_t phase = 0; phase < PHASE_COUNT; phase++) {
+         out << ' ' << phaseName(phase) << '=' << getPhaseStackPeak((LoopPhase)phase);
+       }
+       out << eol;
+       break;
+     case MEMORY_CLOSEST: {
+       uint8_t deepest = PHASE_SETUP;
+       for (uint8_t phase = 0; phase < PHASE_COUNT; phase++) {
+         if (getPhaseStackPeak((LoopPhase)phase) > getPhaseStackPeak((LoopPhase)deepest)) {
+           deepest = phase;
+         }
+       }
+       out << F("Closest to Collision: ") << phaseName(deepest) << eol;
+       break;
+     }
+     default:
+       return false;
+   }
+   return true;
+ }
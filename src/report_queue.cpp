@@ -0,0 +1,98 @@
+/*
+ * Report Queue implementation
+ * Holds the chunk currently being sent and a small FIFO of reports behind
+ * it. Chunks are written whole, so report lines cannot be split by log
+ * output written between loop passes.
+ */
+
+ #include "report_queue.h"
+ #include "system_context.h"
+
+ /*
+  * Queue a report for output; false (with an error line) if the queue is full
+  */
+ bool queueReport(ReportStep report) {
+   ReportQueue& queue = ctx().reportQueue;
+   if (queue.count >= REPORT_QUEUE_SIZE) {
+     LOG_MINIMAL(F("ERROR: Report queue full, try again"));
+     return false;
+   }
+   queue.waiting[(queue.head + queue.count) % REPORT_QUEUE_SIZE] = report;
+   queue.count++;
+   return true;
+ }
+
+ /*
+  * Fill the queue's pending chunk with the next non-empty chunk, moving on to
+  * the next queued report when one finishes; false when nothing is left
+  */
+ static bool nextChunk() {
+   ReportQueue& queue = ctx().reportQueue;
+   while (true) {
+     if (queue.active == NULL) {
+       if (queue.count == 0) return false;
+       queue.active = queue.waiting[queue.head];
+       queue.head = (queue.head + 1) % REPORT_QUEUE_SIZE;
+       queue.count--;
+       queue.activeStep = 0;
+     }
+
+     queue.pending.clear();
+     ReportWriter out(queue.pending);
+     if (!queue.active(queue.activeStep++, out)) {
+       queue.active = NULL;
+       continue;
+     }
+     if (queue.pending.truncated()) queue.truncatedChunks++;
+     if (queue.pending.length() > 0) return true;
+   }
+ }
+
+ /*
+  * Send as many whole chunks as the TX buffer has room for (once per loop pass)
+  */
+ void serviceReports() {
+   ReportQueue& queue = ctx().reportQueue;
+   if (queue.pending.length() == 0 && queue.active == NULL && queue.count == 0) return;
+
+   Print& output = queue.output ? *queue.output : Serial;
+   unsigned long start = micros();
+   while (queue.pending.length() > 0 || nextChunk()) {
+     if (output.availableForWrite() < queue.pending.length()) break;
+     output.write((const uint8_t*)queue.pending.c_str(), queue.pending.length());
+     queue.pending.clear();
+   }
+
+   unsigned long pass = micros() - start;
+   if (pass > queue.passMax) queue.passMax = pass;
+ }
+
+ /*
+  * True while any report output is still to be sent
+  */
+ bool reportPending() {
+   ReportQueue& queue = ctx().reportQueue;
+   return queue.pending.length() > 0 || queue.active != NULL || queue.count > 0;
+ }
+
+ /*
+  * Longest single serviceReports() pass so far, in microseconds
+  */
+ unsigned long getReportPassMax() {
+   return ctx().reportQueue.passMax;
+ }
+
+ /*
+  * Report chunks cut short because a step wrote more than REPORT_CHUNK_MAX
+  */
+ unsigned int getReportTruncations() {
+   return ctx().reportQueue.truncatedChunks;
+ }
+
+ /*
+  * Send reports somewhere other than Serial (NULL goes back to Serial).
+  * The output must report its free space through availableForWrite()
+  */
+ void setReportOutput(Print* output) {
+   ctx().reportQueue.output = output;
+ }
@@ -0,0 +1,141 @@
+/*
+ * Sampling Policy implementation
+ * Each analog channel is sampled at an interval picked by the current
+ * SystemState: slow while IDLE, fast during ALERT and ALARM. While a
+ * channel's readings stay flat the interval doubles, up to the channel's
+ * maxBackoff, and drops back to the base interval on the first real change.
+ *
+ * Timer1 counts each channel down and marks it due; readAnalogSensors()
+ * takes the due channels from the main loop.
+ */
+
+ #include "sampling_policy.h"
+ #include "critical_path.h"
+ #include "system_context.h"
+ #include <util/atomic.h>
+
+ // Per-channel policy, indexed by AnalogChannel
+ static const SamplingPolicy samplingPolicies[ANALOG_CHANNEL_COUNT] PROGMEM = {
+   // IDLE, MONITORING, ALERT, ALARM (ms); max backoff; flat samples; flat delta
+   {{8000, 2000, 250, 500}, 2, 4, 0},    // Temperature, °C
+   {{4000, 1000, 250, 250}, 2, 4, 10}    // Gas, ADC counts
+ };
+
+ static const char channelNameTemp[] PROGMEM = "Temperature";
+ static const char channelNameGas[] PROGMEM = "Gas";
+ static const char* const channelNames[ANALOG_CHANNEL_COUNT] PROGMEM = {
+   channelNameTemp,
+   channelNameGas
+ };
+
+ /*
+  * Apply a channel's interval for the current state and backoff. A shorter
+  * interval takes effect at once rather than after the old countdown
+  */
+ static void rescheduleChannel(uint8_t channel) {
+   ChannelSchedule& schedule = ctx().channelSchedules[channel];
+   uint32_t intervalMs = pgm_read_word(&samplingPolicies[channel].interval[ctx().samplingTimers.scheduledState]);
+   intervalMs <<= schedule.backoff;
+   if (intervalMs > 0xFFFF) intervalMs = 0xFFFF;
+   schedule.intervalMs = intervalMs;
+
+   uint16_t ticks = intervalMs * INPUT_SAMPLE_HZ / 1000;
+   if (ticks == 0) ticks = 1;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+     unsigned long maskedAt = micros();
+     ctx().samplingTimers.reload[channel] = ticks;
+     if (ctx().samplingTimers.countdown[channel] > ticks) ctx().samplingTimers.countdown[channel] = ticks;
+     noteMaskedWindow(maskedAt);
+   }
+ }
+
+ /*
+  * Schedule every channel from the current state, with the first sample
+  * due on the next tick
+  */
+ void samplingInit() {
+   ctx().samplingTimers.scheduledState = ctx().currentState;
+   for (uint8_t channel = 0; channel < ANALOG_CHANNEL_COUNT; channel++) {
+     ctx().channelSchedules[channel].backoff = 0;
+     ctx().channelSchedules[channel].flatCount = 0;
+     ctx().samplingTimers.countdown[channel] = 1;
+     rescheduleChannel(channel);
+   }
+ }
+
+ /*
+  * Count the channels down (Timer1 ISR context)
+  */
+ void samplingTick() {
+   for (uint8_t channel = 0; channel < ANALOG_CHANNEL_COUNT; channel++) {
+     if (--ctx().samplingTimers.countdown[channel] == 0) {
+       ctx().samplingTimers.countdown[channel] = ctx().samplingTimers.reload[channel];
+       ctx().samplingTimers.due |= CHANNEL_BIT(channel);
+     }
+   }
+ }
+
+ /*
+  * Take and clear the CHANNEL_BIT mask of channels due for a sample.
+  * A state change since the last call resets backoff and reschedules first
+  */
+ uint8_t takeDueChannels() {
+   if (ctx().currentState != ctx().samplingTimers.scheduledState) {
+     ctx().samplingTimers.scheduledState = ctx().currentState;
+     for (uint8_t channel = 0; channel < ANALOG_CHANNEL_COUNT; channel++) {
+       ctx().channelSchedules[channel].backoff = 0;
+       ctx().channelSchedules[channel].flatCount = 0;
+       rescheduleChannel(channel);
+     }
+   }
+
+   // A single-byte read needs no mask; only clearing races the ISR
+   if (ctx().samplingTimers.due == 0) return 0;
+
+   uint8_t due;
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+     unsigned long maskedAt = micros();
+     due = ctx().samplingTimers.due;
+     ctx().samplingTimers.due = 0;
+     noteMaskedWindow(maskedAt);
+   }
+   return due;
+ }
+
+ /*
+  * Feed a new reading into the channel's flat-signal backoff
+  */
+ void recordChannelSample(AnalogChannel channel, int value) {
+   ChannelSchedule& schedule = ctx().channelSchedules[channel];
+   int flatDelta = (int16_t)pgm_read_word(&samplingPolicies[channel].flatDelta);
+
+   if (abs(value - schedule.lastValue) <= flatDelta) {
+     if (schedule.backoff < pgm_read_byte(&samplingPolicies[channel].maxBackoff) &&
+         ++schedule.flatCount >= pgm_read_byte(&samplingPolicies[channel].flatSamples)) {
+       schedule.backoff++;
+       schedule.flatCount = 0;
+       rescheduleChannel(channel);
+     }
+   } else {
+     schedule.flatCount = 0;
+     if (schedule.backoff > 0) {
+       schedule.backoff = 0;
+       rescheduleChannel(channel);
+     }
+   }
+   schedule.lastValue = value;
+ }
+
+ /*
+  * Print one channel's effective sample rate (STATUS)
+  */
+ void printSamplingChannel(AnalogChannel channel, ReportWriter& out) {
+   const ChannelSchedule& schedule = ctx().channelSchedules[channel];
+   out << (const __FlashStringHelper*)pgm_read_ptr(&channelNames[channel]) << F(": ")
+       << fixed(1000.0 / schedule.intervalMs, 2) << F("Hz (every ") << schedule.intervalMs << F("ms");
+   if (schedule.backoff > 0) {
+     out << F(", flat x") << (1 << schedule.backoff);
+   }
+   out << ')' << eol;
+ }
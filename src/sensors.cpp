@@ -4,136 +4,292 @@
  */
 
  #include "sensors.h"
+ #include "memory_monitor.h"
+ #include "state_machine.h"
+ #include "transition_audit.h"
+ #include "critical_path.h"
+ #include "sampling_policy.h"
+ #include "report_queue.h"
+ #include "isr_shared.h"
+ #include "system_context.h"
+ #include <ctype.h>
+
+ // Out-of-range warnings repeat at most this often while a reading stays out
+ #define SENSOR_WARNING_REPEAT 2000 // ms
+ 
+ /*
+  * Decide whether an out-of-range warning is due; the first sample out of
+  * range always warns
+  */
+ static bool warningDue(bool outOfRange, bool& warned, unsigned long& warnedAt, unsigned long now) {
+   if (!outOfRange) {
+     warned = false;
+     return false;
+   }
+   if (warned && now - warnedAt < SENSOR_WARNING_REPEAT) return false;
+   warned = true;
+   warnedAt = now;
+   return true;
+ }
+ 
  /*
-  * Read analog temperature sensor with reduced logging noise
+  * Read the analog channels that are due under the sampling policy, with
+  * reduced logging noise
   */
  void readAnalogSensors() {
+   uint8_t due = takeDueChannels();
+   if (!due) return;
+   
    unsigned long currentTime = millis();
+   int prevTemp = ctx().sensors.temperature;
+   int prevGas = ctx().sensors.gasReading;
    
-   if (currentTime - sensors.tempLastRead >= TEMP_READ_INTERVAL) {
-     int adcValue = analogRead(TEMP_SENSOR_PIN);
-     float prevTemp = sensors.temperature;
-     int prevGas = sensors.gasReading;
-     
-     // Convert to approximate temperature
-     sensors.temperature = 1 / (log(1 / (1023. / adcValue - 1)) / 3950 + 1.0 / 298.15) - 273.15;
-     sensors.gasReading = analogRead(GAS_A_PIN);
-     sensors.tempLastRead = currentTime;
+   if (due & CHANNEL_BIT(CHANNEL_TEMP)) {
+     ctx().sensors.temperature = convertTemperature(analogRead(TEMP_SENSOR_PIN));
+     recordChannelSample(CHANNEL_TEMP, ctx().sensors.temperature);
+   }
+   if (due & CHANNEL_BIT(CHANNEL_GAS)) {
+     ctx().sensors.gasReading = analogRead(GAS_A_PIN);
+     recordChannelSample(CHANNEL_GAS, ctx().sensors.gasReading);
+   }
+   if (ctx().sensors.temperature != prevTemp || ctx().sensors.gasReading != prevGas) {
+     markStateInputsDirty(STATE_INPUT_ANALOG);
+   }
  
-     // Only log if significant change or verbose mode
-     bool significantTempChange = abs(sensors.temperature - prevTemp) > 1.0; // 1°C threshold
-     bool significantGasChange = abs(sensors.gasReading - prevGas) > 50; // 50 unit threshold
-     
-     if (systemFlags.verboseLogging || significantTempChange || significantGasChange) {
-       LOG_VERBOSE("SENSOR: Temperature = " + String(sensors.temperature, 1) + "°C; Gas = " + String(sensors.gasReading));
-     }
-     
-     // Always log warnings regardless of log level
-     if (sensors.temperature > TEMP_HIGH_WARNING || sensors.temperature < TEMP_LOW_WARNING) {
-       LOG_MINIMAL("WARNING: Temperature " + String(sensors.temperature, 1) + "°C outside safe range");
-     }
-     if (sensors.gasReading > GAS_WARNING) {
-       LOG_MINIMAL("WARNING: Gas level " + String(sensors.gasReading) + " above threshold");
-     }
+   // Only log if significant change or verbose mode
+   bool significantTempChange = abs(ctx().sensors.temperature - prevTemp) > 1; // 1°C threshold
+   bool significantGasChange = abs(ctx().sensors.gasReading - prevGas) > 50; // 50 unit threshold
+   
+   if (ctx().systemFlags.verboseLogging || significantTempChange || significantGasChange) {
+     LOG_VERBOSE(F("SENSOR: Temperature = ") << ctx().sensors.temperature << F("°C; Gas = ") << ctx().sensors.gasReading);
+   }
+   
+   // Always log warnings regardless of log level
+   if ((due & CHANNEL_BIT(CHANNEL_TEMP)) &&
+       warningDue(ctx().sensors.temperature > TEMP_HIGH_WARNING || ctx().sensors.temperature < TEMP_LOW_WARNING,
+                  ctx().sensorWarnings.tempWarned, ctx().sensorWarnings.tempWarnedAt, currentTime)) {
+     LOG_MINIMAL(F("WARNING: Temperature ") << ctx().sensors.temperature << F("°C outside safe range"));
+   }
+   if ((due & CHANNEL_BIT(CHANNEL_GAS)) &&
+       warningDue(ctx().sensors.gasReading > GAS_WARNING, ctx().sensorWarnings.gasWarned, ctx().sensorWarnings.gasWarnedAt, currentTime)) {
+     LOG_MINIMAL(F("WARNING: Gas level ") << ctx().sensors.gasReading << F(" above threshold"));
    }
  }
  
+ /*
+  * Convert a thermistor ADC reading to approximate degrees Celsius
+  * Beta-model NTC (B = 3950, 10k at 25°C) on a voltage divider
+  */
+ int convertTemperature(int adcValue) {
+   return 1 / (log(1 / (1023. / adcValue - 1)) / 3950 + 1.0 / 298.15) - 273.15;
+ }
+ 
  /*
   * Enhanced serial command processing with input echoing and new commands
+  * Collects bytes without blocking; a command ends at CR/LF, or after
+  * SERIAL_COMMAND_TIMEOUT of silence for terminals that send no line ending
   */
  void processSerialCommands() {
-   if (Serial.available()) {
-     String command = Serial.readString();
-     command.trim();
-     
-     // Echo user input (before converting to uppercase)
-     Serial.print("CMD> ");
-     Serial.println(command);
-     
-     command.toUpperCase();
-     
-     if (command == "ARM") {
-       systemFlags.armed = true;
-       currentState = MONITORING;
-       pendingState = MONITORING; // Reset pending state
-       LOG_MINIMAL("SYSTEM: Armed - Monitoring mode active");
-     }
-     else if (command == "DISARM") {
-       systemFlags.armed = false;
-       systemFlags.alarmActive = false;
-       currentState = IDLE;
-       pendingState = IDLE; // Reset pending state
-       digitalWrite(ALARM_LED_PIN, LOW);
-       digitalWrite(BUZZER_PIN, LOW);
-       LOG_MINIMAL("SYSTEM: Disarmed - Idle mode");
-     }
-     else if (command == "STATUS") {
-       printSystemStatus();
-     }
-     else if (command == "VERBOSE") {
-       systemFlags.verboseLogging = true;
-       systemFlags.logLevel = 2;
-       Serial.println("SYSTEM: Verbose logging enabled");
-     }
-     else if (command == "QUIET") {
-       systemFlags.verboseLogging = false;
-       systemFlags.logLevel = 0;
-       Serial.println("SYSTEM: Quiet mode enabled (minimal logging)");
-     }
-     else if (command == "NORMAL") {
-       systemFlags.verboseLogging = false;
-       systemFlags.logLevel = 1;
-       Serial.println("SYSTEM: Normal logging enabled");
-     }
-     else if (command == "DEBUG") {
-       printDebugInfo();
-     }
-     else if (command == "HELP") {
-       printHelpCommands();
-     }
-     else {
-       Serial.println("ERROR: Unknown command '" + command + "'. Type HELP for available commands.");
+   bool complete = false;
+   
+   while (Serial.available()) {
+     char c = Serial.read();
+     ctx().commandInput.lastByte = millis();
+     if (c == '\r' || c == '\n') {
+       complete = true;
+       break;
      }
+     ctx().commandInput.line.write(c);
    }
+   
+   if (ctx().commandInput.line.length() == 0) return;
+   if (!complete && millis() - ctx().commandInput.lastByte < SERIAL_COMMAND_TIMEOUT) return;
+   
+   char* command = trimCommand(ctx().commandInput.line.data());
+   
+   // Echo user input (before converting to uppercase)
+   ReportLine(Serial) << F("CMD> ") << command;
+   
+   // The buffer dropped the rest of the line; running what is left could
+   // turn a longer line into a valid command
+   if (ctx().commandInput.line.truncated()) {
+     ReportLine(Serial) << F("ERROR: Command too long (max ") << SERIAL_COMMAND_MAX << F(" characters)");
+     ctx().commandInput.line.clear();
+     return;
+   }
+   
+   for (char* p = command; *p; p++) {
+     *p = toupper((unsigned char)*p);
+   }
+   executeCommand(command);
+   ctx().commandInput.line.clear();
+ }
+ 
+ /*
+  * Strip leading and trailing whitespace in place
+  */
+ char* trimCommand(char* line) {
+   while (isspace((unsigned char)*line)) line++;
+   char* end = line + strlen(line);
+   while (end > line && isspace((unsigned char)end[-1])) end--;
+   *end = '\0';
+   return line;
+ }
+ 
+ /*
+  * Audit a state change forced by ARM/DISARM, which bypass debouncing
+  */
+ static void applyCommandTransition(SystemState target) {
+   if (ctx().pendingState != ctx().currentState && ctx().pendingState != target) {
+     recordCancelledTransition(ctx().pendingState);
+   }
+   if (ctx().currentState != target) {
+     recordTransition(ctx().currentState, target, TRIGGER_COMMAND, 0);
+   }
+ }
+ 
+ /*
+  * Execute a trimmed, upper-case command
+  */
+ void executeCommand(const char* command) {
+   if (strcmp_P(command, PSTR("ARM")) == 0) {
+     applyCommandTransition(MONITORING);
+     ctx().systemFlags.armed = true;
+     ctx().currentState = MONITORING;
+     ctx().pendingState = MONITORING; // Reset pending state
+     publishCriticalArming();
+     markStateInputsDirty(STATE_INPUT_COMMAND);
+     LOG_MINIMAL(F("SYSTEM: Armed - Monitoring mode active"));
+   }
+   else if (strcmp_P(command, PSTR("DISARM")) == 0) {
+     ctx().systemFlags.armed = false;
+     ctx().systemFlags.alarmActive = false;
+     applyCommandTransition(IDLE);
+     ctx().currentState = IDLE;
+     ctx().pendingState = IDLE; // Reset pending state
+     publishCriticalArming();
+     markStateInputsDirty(STATE_INPUT_COMMAND);
+     digitalWrite(ALARM_LED_PIN, LOW);
+     digitalWrite(BUZZER_PIN, LOW);
+     LOG_MINIMAL(F("SYSTEM: Disarmed - Idle mode"));
+   }
+   else if (strcmp_P(command, PSTR("STATUS")) == 0) {
+     printSystemStatus();
+   }
+   else if (strcmp_P(command, PSTR("VERBOSE")) == 0) {
+     ctx().systemFlags.verboseLogging = true;
+     ctx().systemFlags.logLevel = 2;
+     Serial.println(F("SYSTEM: Verbose logging enabled"));
+   }
+   else if (strcmp_P(command, PSTR("QUIET")) == 0) {
+     ctx().systemFlags.verboseLogging = false;
+     ctx().systemFlags.logLevel = 0;
+     Serial.println(F("SYSTEM: Quiet mode enabled (minimal logging)"));
+   }
+   else if (strcmp_P(command, PSTR("NORMAL")) == 0) {
+     ctx().systemFlags.verboseLogging = false;
+     ctx().systemFlags.logLevel = 1;
+     Serial.println(F("SYSTEM: Normal logging enabled"));
+   }
+   else if (strcmp_P(command, PSTR("DEBUG")) == 0) {
+     printDebugInfo();
+   }
+   else if (strcmp_P(command, PSTR("TRANSITIONS")) == 0) {
+     printTransitionReport();
+   }
+   else if (strcmp_P(command, PSTR("LATENCY")) == 0) {
+     printLatencyReport();
+   }
+   else if (strcmp_P(command, PSTR("HELP")) == 0) {
+     printHelpCommands();
+   }
+   else {
+     ReportLine(Serial) << F("ERROR: Unknown command '") << command << F("'. Type HELP for available commands.");
+   }
+ }
+ 
+ // Command list for HELP, one line per step
+ static const char helpLine0[] PROGMEM = "\n=== AVAILABLE COMMANDS ===";
+ static const char helpLine1[] PROGMEM = "ARM         - Arm the monitoring system";
+ static const char helpLine2[] PROGMEM = "DISARM      - Disarm the system and stop alarms";
+ static const char helpLine3[] PROGMEM = "STATUS      - Display current system status";
+ static const char helpLine4[] PROGMEM = "VERBOSE     - Enable detailed logging";
+ static const char helpLine5[] PROGMEM = "NORMAL      - Enable normal logging level";
+ static const char helpLine6[] PROGMEM = "QUIET       - Enable minimal logging (warnings only)";
+ static const char helpLine7[] PROGMEM = "DEBUG       - Show debug information";
+ static const char helpLine8[] PROGMEM = "TRANSITIONS - Show state transition history";
+ static const char helpLine9[] PROGMEM = "LATENCY     - Show critical alarm fast path timing";
+ static const char helpLine10[] PROGMEM = "HELP        - Show this command list";
+ static const char helpLine11[] PROGMEM = "==========================\n";
+ static const char* const helpLines[] PROGMEM = {
+   helpLine0, helpLine1, helpLine2, helpLine3, helpLine4, helpLine5,
+   helpLine6, helpLine7, helpLine8, helpLine9, helpLine10, helpLine11
+ };
+ 
+ static bool helpReportStep(uint8_t step, ReportWriter& out) {
+   if (step >= sizeof(helpLines) / sizeof(helpLines[0])) return false;
+   out << (const __FlashStringHelper*)pgm_read_ptr(&helpLines[step]) << eol;
+   return true;
  }
  
  /*
-  * Print available commands
+  * Queue the list of available commands
   */
  void printHelpCommands() {
-   Serial.println("\n=== AVAILABLE COMMANDS ===");
-   Serial.println("ARM      - Arm the monitoring system");
-   Serial.println("DISARM   - Disarm the system and stop alarms");
-   Serial.println("STATUS   - Display current system status");
-   Serial.println("VERBOSE  - Enable detailed logging");
-   Serial.println("NORMAL   - Enable normal logging level");
-   Serial.println("QUIET    - Enable minimal logging (warnings only)");
-   Serial.println("DEBUG    - Show debug information");
-   Serial.println("HELP     - Show this command list");
-   Serial.println("==========================\n");
+   queueReport(helpReportStep);
  }
  
+ // Steps of the DEBUG report
+ enum DebugStep {
+   DEBUG_HEADER,
+   DEBUG_CURRENT_STATE,
+   DEBUG_PENDING_STATE,
+   DEBUG_STATE_CHANGE_TIME,
+   DEBUG_CURRENT_TIME,
+   DEBUG_TIME_IN_STATE,
+   DEBUG_LOG_LEVEL,
+   DEBUG_VERBOSE,
+   DEBUG_REPORT_PASS,
+   DEBUG_ISR_SNAPSHOT,
+   DEBUG_STATE_EVALUATIONS,
+   DEBUG_MEMORY_FIRST,
+   DEBUG_FOOTER = DEBUG_MEMORY_FIRST + MEMORY_REPORT_STEPS
+ };
+ 
  /*
-  * Print debug information for troubleshooting
+  * Debug information for troubleshooting, one line per step
   */
- void printDebugInfo() {
-   Serial.println("\n=== DEBUG INFORMATION ===");
-   Serial.print("Current State: "); Serial.println(stateToString(currentState));
-   Serial.print("Pending State: "); Serial.println(stateToString(pendingState));
-   Serial.print("State Change Time: "); Serial.println(stateChangeTime);
-   Serial.print("Current Time: "); Serial.println(millis());
-   Serial.print("Time in Current State: "); Serial.println(millis() - systemFlags.lastStateChange);
-   Serial.print("Log Level: "); Serial.println(systemFlags.logLevel);
-   Serial.print("Verbose Logging: "); Serial.println(systemFlags.verboseLogging ? "ON" : "OFF");
-   Serial.print("Free RAM: "); Serial.println(getFreeRAM());
-   Serial.println("=========================\n");
+ static bool debugReportStep(uint8_t step, ReportWriter& out) {
+   if (step >= DEBUG_MEMORY_FIRST && step < DEBUG_FOOTER) {
+     return memoryReportStep(step - DEBUG_MEMORY_FIRST, out);
+   }
+   
+   switch (step) {
+     case DEBUG_HEADER: out << F("\n=== DEBUG INFORMATION ===") << eol; break;
+     case DEBUG_CURRENT_STATE: out << F("Current State: ") << stateToString(ctx().currentState) << eol; break;
+     case DEBUG_PENDING_STATE: out << F("Pending State: ") << stateToString(ctx().pendingState) << eol; break;
+     case DEBUG_STATE_CHANGE_TIME: out << F("State Change Time: ") << ctx().stateChangeTime << eol; break;
+     case DEBUG_CURRENT_TIME: out << F("Current Time: ") << millis() << eol; break;
+     case DEBUG_TIME_IN_STATE: out << F("Time in Current State: ") << getTimeInState() << eol; break;
+     case DEBUG_LOG_LEVEL: out << F("Log Level: ") << ctx().systemFlags.logLevel << eol; break;
+     case DEBUG_VERBOSE: out << F("Verbose Logging: ") << (ctx().systemFlags.verboseLogging ? F("ON") : F("OFF")) << eol; break;
+     case DEBUG_REPORT_PASS:
+       out << F("Report Pass Max: ") << getReportPassMax() << F("us (truncated chunks: ") << getReportTruncations() << ')' << eol;
+       break;
+     case DEBUG_ISR_SNAPSHOT: out << F("ISR Snapshot Retries: ") << getIsrSnapshotRetries() << eol; break;
+     case DEBUG_STATE_EVALUATIONS:
+       out << F("State Evaluations: ") << getStateEvaluations() << F(" run, ")
+           << getStateEvaluationsSkipped() << F(" skipped") << eol;
+       break;
+     case DEBUG_FOOTER: out << F("=========================\n") << eol; break;
+     default: return false;
+   }
+   return true;
  }
  
  /*
-  * Get free RAM for debugging
+  * Queue the debug information report
   */
- int getFreeRAM() {
-   extern int __heap_start, *__brkval;
-   int v;
-   return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval);
- }
\ No newline at end of file
+ void printDebugInfo() {
+   queueReport(debugReportStep);
+ }
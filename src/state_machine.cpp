@@ -4,39 +4,97 @@
 
  #include "state_machine.h"
  #include "system_config.h"
+ #include "transition_audit.h"
+ #include "critical_path.h"
+ #include "system_context.h"
 
+ // Trigger names in TRIGGER_* bit order
+ static const char triggerMotion[] PROGMEM = "Motion";
+ static const char triggerGasDanger[] PROGMEM = "GasDanger";
+ static const char triggerGasHigh[] PROGMEM = "GasHigh";
+ static const char triggerTempHigh[] PROGMEM = "TempHigh";
+ static const char triggerTempLow[] PROGMEM = "TempLow";
+ static const char triggerCommand[] PROGMEM = "Command";
+ static const char* const triggerNameTable[TRIGGER_NAME_COUNT] PROGMEM = {
+   triggerMotion, triggerGasDanger, triggerGasHigh, triggerTempHigh, triggerTempLow, triggerCommand
+ };
+
+ /*
+  * Flag state machine inputs as changed so the next pass evaluates
+  */
+ void markStateInputsDirty(uint8_t inputs) {
+   ctx().stateEvaluation.dirtyInputs |= inputs;
+ }
+ 
+ /*
+  * Work out when the state machine next needs to run with no input change:
+  * a pending change's debounce expiry, or the alarm timeout
+  */
+ static void scheduleDeadline() {
+   if (ctx().pendingState != ctx().currentState) {
+     ctx().stateEvaluation.nextDeadline = ctx().stateChangeTime + getStateDebounceTime(ctx().pendingState);
+     ctx().stateEvaluation.deadlinePending = true;
+   } else if (ctx().currentState == ALARM && ctx().systemFlags.armed) {
+     ctx().stateEvaluation.nextDeadline = millis() + stampMsUntilExpired(ctx().systemFlags.alarmStartTime, ALARM_TIMEOUT);
+     ctx().stateEvaluation.deadlinePending = true;
+   } else {
+     ctx().stateEvaluation.deadlinePending = false;
+   }
+ }
+ 
+ unsigned long getStateEvaluations() {
+   return ctx().stateEvaluation.evaluations;
+ }
+ 
+ unsigned long getStateEvaluationsSkipped() {
+   return ctx().stateEvaluation.skipped;
+ }
+ 
  /*
   * Main state machine processor
-  * Coordinates system responses based on sensor inputs and current state
+  * Coordinates system responses based on sensor inputs and current state.
+  * Evaluates only when an input is dirty or a deadline has come due
   */
  void processStateMachine() {
-  SystemState desiredState = currentState;
+  // A latched critical edge goes straight to ALARM
+  commitCriticalAlarm();
+  
   unsigned long currentTime = millis();
+  bool deadlineDue = ctx().stateEvaluation.deadlinePending && (long)(currentTime - ctx().stateEvaluation.nextDeadline) >= 0;
+  if (!ctx().stateEvaluation.dirtyInputs && !deadlineDue) {
+    ctx().stateEvaluation.skipped++;
+    return;
+  }
+  // Cleared first: anything marked while evaluating (a transition) stays dirty
+  ctx().stateEvaluation.dirtyInputs = 0;
+  ctx().stateEvaluation.evaluations++;
+  
+  SystemState desiredState = ctx().currentState;
    
-   switch (currentState) {
+   switch (ctx().currentState) {
      case IDLE:
        // System disarmed - only monitor for commands
-       if (systemFlags.armed) {
+       if (ctx().systemFlags.armed) {
          desiredState = MONITORING;
        }
        break;
        
      case MONITORING:
        // System armed - monitor for interrupts
-       if (!systemFlags.armed) {
+       if (!ctx().systemFlags.armed) {
         desiredState = IDLE;
       }
-      else if (sensors.pir || 
-               (sensors.gasReading > GAS_WARNING && sensors.gasSafe) ||
-               sensors.temperature > TEMP_HIGH_WARNING ||
-               sensors.temperature < TEMP_LOW_WARNING) {
+      else if (ctx().sensors.pir || 
+               (ctx().sensors.gasReading > GAS_WARNING && ctx().sensors.gasSafe) ||
+               ctx().sensors.temperature > TEMP_HIGH_WARNING ||
+               ctx().sensors.temperature < TEMP_LOW_WARNING) {
         desiredState = ALERT;
       }
       break;
        
      case ALERT:
        // Brief alert state before full alarm
-       if (!systemFlags.armed) {
+       if (!ctx().systemFlags.armed) {
         desiredState = IDLE;
       }
       else if (shouldEscalateToAlarm()) {
@@ -50,36 +108,44 @@
        
      case ALARM:
        // Full alarm state
-       if (!systemFlags.armed) {
+       if (!ctx().systemFlags.armed) {
         desiredState = IDLE;
-        systemFlags.alarmActive = false;
+        ctx().systemFlags.alarmActive = false;
       }
-      else if (currentTime - systemFlags.alarmStartTime > ALARM_TIMEOUT) {
+      else if (stampExpired(ctx().systemFlags.alarmStartTime, ALARM_TIMEOUT)) {
         desiredState = MONITORING;
-        systemFlags.alarmActive = false;
-        LOG_NORMAL("STATE: Alarm timeout - Returning to monitoring");
+        ctx().systemFlags.alarmActive = false;
+        LOG_NORMAL(F("STATE: Alarm timeout - Returning to monitoring"));
       }
       break;
    }
    
    // Handle state debouncing
-  if (desiredState != currentState) {
-    if (pendingState != desiredState) {
-      // New state change request
-      pendingState = desiredState;
-      stateChangeTime = currentTime;
-      LOG_VERBOSE("STATE: Change requested to " + stateToString(desiredState) + " - debouncing...");
+  if (desiredState != ctx().currentState) {
+    if (ctx().pendingState != desiredState) {
+      // New state change request, replacing any other pending change
+      if (ctx().pendingState != ctx().currentState) {
+        recordCancelledTransition(ctx().pendingState);
+      }
+      ctx().pendingState = desiredState;
+      ctx().stateChangeTime = currentTime;
+      LOG_VERBOSE(F("STATE: Change requested to ") << stateToString(desiredState) << F(" - debouncing..."));
     }
-    else if (currentTime - stateChangeTime >= getStateDebounceTime(desiredState)) {
+    else if (currentTime - ctx().stateChangeTime >= getStateDebounceTime(desiredState)) {
       // State has been stable long enough, commit the change
       executeStateTransition(desiredState);
-      pendingState = currentState; // Reset pending state
+      ctx().pendingState = ctx().currentState; // Reset pending state
     }
   }
   else {
     // Current conditions match current state, reset pending
-    pendingState = currentState;
+    if (ctx().pendingState != ctx().currentState) {
+      recordCancelledTransition(ctx().pendingState);
+    }
+    ctx().pendingState = ctx().currentState;
   }
+  
+  scheduleDeadline();
 }
 
 /*
@@ -109,12 +175,12 @@ bool shouldEscalateToAlarm() {
   bool criticalCondition = false;
   
   int activeSensors = 0;
-  if (sensors.pir) activeSensors++;
-  if (sensors.gasReading > GAS_WARNING) activeSensors++;
-  if (sensors.temperature > TEMP_HIGH_WARNING || sensors.temperature < TEMP_LOW_WARNING) activeSensors++;
+  if (ctx().sensors.pir) activeSensors++;
+  if (ctx().sensors.gasReading > GAS_WARNING) activeSensors++;
+  if (ctx().sensors.temperature > TEMP_HIGH_WARNING || ctx().sensors.temperature < TEMP_LOW_WARNING) activeSensors++;
   
   multipleSensors = (activeSensors >= 2);
-  criticalCondition = (sensors.pir && !sensors.gasSafe); // Motion + gas danger
+  criticalCondition = (ctx().sensors.pir && !ctx().sensors.gasSafe); // Motion + gas danger
   
   return multipleSensors || criticalCondition;
 }
@@ -123,71 +189,81 @@ bool shouldEscalateToAlarm() {
  * Check if alert conditions have been cleared
  */
 bool alertConditionsCleared() {
-  return !sensors.pir && 
-         sensors.gasSafe && 
-         sensors.gasReading <= GAS_WARNING &&
-         sensors.temperature <= TEMP_HIGH_WARNING &&
-         sensors.temperature >= TEMP_LOW_WARNING;
+  return !ctx().sensors.pir && 
+         ctx().sensors.gasSafe && 
+         ctx().sensors.gasReading <= GAS_WARNING &&
+         ctx().sensors.temperature <= TEMP_HIGH_WARNING &&
+         ctx().sensors.temperature >= TEMP_LOW_WARNING;
 }
 
 /*
  * Execute state transition with logging and actions
  */
-void executeStateTransition(SystemState newState) {
-  if (newState == currentState) return;
+void executeStateTransition(SystemState newState, uint8_t latchedTriggers) {
+  if (newState == ctx().currentState) return;
+  
+  uint8_t triggers = getTriggerMask() | latchedTriggers;
+  unsigned long debounceWait = (ctx().pendingState == newState) ? millis() - ctx().stateChangeTime : 0;
   
   // Log state transition (level depends on importance)
-  if (newState == ALARM || currentState == ALARM) {
-    LOG_MINIMAL("STATE: " + stateToString(currentState) + " -> " + stateToString(newState));
+  if (newState == ALARM || ctx().currentState == ALARM) {
+    LOG_MINIMAL(F("STATE: ") << stateToString(ctx().currentState) << F(" -> ") << stateToString(newState));
   } else {
-    LOG_NORMAL("STATE: " + stateToString(currentState) + " -> " + stateToString(newState));
+    LOG_NORMAL(F("STATE: ") << stateToString(ctx().currentState) << F(" -> ") << stateToString(newState));
   }
   
   // Log specific trigger conditions for alerts/alarms
   if (newState == ALERT || newState == ALARM) {
-    logTriggerConditions();
+    logTriggerConditions(triggers);
   }
   
-  previousState = currentState;
-  currentState = newState;
-  systemFlags.lastStateChange = millis();
+  recordTransition(ctx().currentState, newState, triggers, debounceWait);
+  ctx().previousState = ctx().currentState;
+  ctx().currentState = newState;
+  publishCriticalArming();
+  markStateInputsDirty(STATE_INPUT_STATE);
   
   // Execute state entry actions
   executeStateActions();
 }
 
 /*
- * Log what conditions triggered the state change
+ * Collect the conditions that currently argue for ALERT/ALARM
  */
-void logTriggerConditions() {
-  if (!systemFlags.verboseLogging && systemFlags.logLevel < 1) return;
-  
-  String triggers = "TRIGGERS: ";
-  bool hasAny = false;
+uint8_t getTriggerMask() {
+  uint8_t triggers = 0;
+  if (ctx().sensors.pir) triggers |= TRIGGER_MOTION;
+  if (!ctx().sensors.gasSafe) triggers |= TRIGGER_GAS_DANGER;
+  if (ctx().sensors.gasReading > GAS_WARNING) triggers |= TRIGGER_GAS_HIGH;
+  if (ctx().sensors.temperature > TEMP_HIGH_WARNING) triggers |= TRIGGER_TEMP_HIGH;
+  if (ctx().sensors.temperature < TEMP_LOW_WARNING) triggers |= TRIGGER_TEMP_LOW;
+  return triggers;
+}
+
+/*
+ * Write the names of the triggers in a mask, or "None"
+ */
+ReportWriter& operator<<(ReportWriter& out, const TriggerNames& names) {
+  if (names.mask == 0) return out << F("None");
   
-  if (sensors.pir) {
-    triggers += "Motion ";
-    hasAny = true;
-  }
-  if (!sensors.gasSafe) {
-    triggers += "GasDanger ";
-    hasAny = true;
-  }
-  if (sensors.gasReading > GAS_WARNING) {
-    triggers += "GasHigh ";
-    hasAny = true;
-  }
-  if (sensors.temperature > TEMP_HIGH_WARNING) {
-    triggers += "TempHigh ";
-    hasAny = true;
-  }
-  if (sensors.temperature < TEMP_LOW_WARNING) {
-    triggers += "TempLow ";
-    hasAny = true;
+  bool first = true;
+  for (uint8_t bit = 0; bit < TRIGGER_NAME_COUNT; bit++) {
+    if (!(names.mask & (1 << bit))) continue;
+    if (!first) out << ' ';
+    out << (const __FlashStringHelper*)pgm_read_ptr(&triggerNameTable[bit]);
+    first = false;
   }
+  return out;
+}
+
+/*
+ * Log what conditions triggered the state change
+ */
+void logTriggerConditions(uint8_t triggers) {
+  if (!ctx().systemFlags.verboseLogging && ctx().systemFlags.logLevel < 1) return;
   
-  if (hasAny) {
-    LOG_NORMAL(triggers);
+  if (triggers) {
+    LOG_NORMAL(F("TRIGGERS: ") << triggerNames(triggers));
   }
 }
 
@@ -195,7 +271,7 @@ void logTriggerConditions() {
  * Execute actions when entering a new state
  */
 void executeStateActions() {
-  switch (currentState) {
+  switch (ctx().currentState) {
     case IDLE:
       digitalWrite(ALARM_LED_PIN, LOW);
       digitalWrite(BUZZER_PIN, LOW);
@@ -212,8 +288,8 @@ void executeStateActions() {
       
     case ALARM:
       digitalWrite(ALARM_LED_PIN, HIGH);
-      systemFlags.alarmStartTime = millis();
-      systemFlags.alarmActive = true;
+      ctx().systemFlags.alarmStartTime = stampNow();
+      ctx().systemFlags.alarmActive = true;
       break;
   }
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 /*
  * System Configuration Implementation
- * Defines all constants and global variables
+ * Defines all constants and system initialisation
  */
 
  #include "system_config.h"
  #include "interrupts.h"
+ #include "memory_monitor.h"
+ #include "state_machine.h"
+ #include "sampling_policy.h"
+ #include "critical_path.h"
+ #include "system_context.h"
 
  // Pin definitions
 
@@ -17,42 +22,25 @@
  const int GAS_A_PIN = A1;         // Analog gas output
  
  // Timing constants
- const unsigned long DEBOUNCE_DELAY = 50;     // ms
  const unsigned long STATE_DEBOUNCE_DELAY = 2000; // ms
  const unsigned long ALARM_TIMEOUT = 10000;   // ms
- const unsigned long TEMP_READ_INTERVAL = 2000; // ms
  const unsigned long SERIAL_UPDATE_INTERVAL = 5000; // ms
  const unsigned long ALERT_TO_ALARM_DELAY = 3000; // ms
+ const unsigned long SERIAL_COMMAND_TIMEOUT = 1000; // ms of silence ending an unterminated command
+ 
+ // Critical alarm fast path (only TRIGGER_MOTION and TRIGGER_GAS_DANGER are usable)
+ const bool CRITICAL_FAST_PATH_ENABLED = true;
+ const uint8_t CRITICAL_TRIGGERS = TRIGGER_MOTION | TRIGGER_GAS_DANGER;
  
  // Threshold constants
  const long GAS_WARNING = 500; // ppm
  const long TEMP_LOW_WARNING = 15; // degrees celsius
  const long TEMP_HIGH_WARNING = 30; // degrees celsius
 
- // Interrupt flags (volatile)
- volatile bool pirChange = false;
- volatile bool gasChange = false;
- volatile bool timerTick = false;
- volatile bool pciTriggered = false;
- 
- // State variables
- SystemState currentState = IDLE;
- SystemState previousState = IDLE;
- SystemState pendingState = IDLE; // for state debouncing
- unsigned long stateChangeTime = 0; // track when state change was initiated
-
- 
- // System data structures
- SensorStates sensors = {false, true, false, false, 0, 0, 0, 0, 0};
- SystemFlags systemFlags = {false, false, false, 0, 0, false, 1};
- 
- // Timing variables
- unsigned long lastSerialUpdate = 0;
- 
  // System initialisation
  void systemInit() {
    Serial.begin(115200);
-   Serial.println("=== Home Monitoring System Initialising ===");
+   Serial.println(F("=== Home Monitoring System Initialising ==="));
    
    // Configure pins
    pinMode(PIR_SENSOR_PIN, INPUT_PULLUP);
@@ -66,23 +54,30 @@
    digitalWrite(ALARM_LED_PIN, LOW);
    digitalWrite(BUZZER_PIN, LOW);
    
+   // Analog sampling starts on the first Timer1 tick
+   samplingInit();
+   
    // Setup interrupts
    setupPinChangeInterrupts();
    setupTimerInterrupt();
    
    // Initialise sensor states
-   sensors.pir = digitalRead(PIR_SENSOR_PIN);
-   sensors.gasSafe = digitalRead(GAS_D_PIN);
-   sensors.pirPrevious = sensors.pir;
-   sensors.gasPrevious = sensors.gasSafe;
+   ctx().sensors.pir = digitalRead(PIR_SENSOR_PIN);
+   ctx().sensors.gasSafe = digitalRead(GAS_D_PIN);
+   ctx().sensors.pirPrevious = ctx().sensors.pir;
+   ctx().sensors.gasPrevious = ctx().sensors.gasSafe;
    
    // Set initial state
-   currentState = IDLE;
-   systemFlags.armed = false;
-   systemFlags.verboseLogging = true;
-   systemFlags.logLevel = 1;
+   ctx().currentState = IDLE;
+   ctx().systemFlags.armed = false;
+   ctx().systemFlags.verboseLogging = true;
+   ctx().systemFlags.logLevel = 1;
+   publishCriticalArming();
+   
+   Serial.println(F("System initialised successfully"));
+   Serial.println(F("Commands: ARM, DISARM, STATUS, VERBOSE, NORMAL, QUIET, DEBUG, TRANSITIONS, LATENCY, HELP"));
+   Serial.println(F("==========================================="));
    
-   Serial.println("System initialised successfully");
-   Serial.println("Commands: ARM, DISARM, STATUS, VERBOSE, QUIET, DEBUG");
-   Serial.println("===========================================");
+   // Start per-phase memory tracking from the stack left by setup
+   memoryMonitorInit();
  }
\ No newline at end of file
@@ -0,0 +1,11 @@
+/*
+ * System Context implementation
+ * The AVR build has exactly one context; native hosts create their own and
+ * select them per thread
+ */
+
+ #include "system_context.h"
+
+ #if defined(__AVR__)
+ SystemContext systemContext;
+ #endif
@@ -0,0 +1,168 @@
+/*
+ * Transition Audit implementation keeps a ring of recent state transitions
+ * plus per-state residency, per-edge counts and cancelled pending changes,
+ * for tuning getStateDebounceTime() against observed behaviour
+ */
+
+ #include "transition_audit.h"
+ #include "state_machine.h"
+ #include "report_queue.h"
+ #include "system_context.h"
+
+ /*
+  * Record a committed transition
+  */
+ void recordTransition(SystemState from, SystemState to, uint8_t triggers, unsigned long debounceWait) {
+   TransitionAudit& audit = ctx().transitionAudit;
+   unsigned long now = millis();
+   TransitionRecord& record = audit.log[audit.head];
+
+   record.timestamp = now;
+   record.from = from;
+   record.to = to;
+   record.triggers = triggers;
+   record.debounceWait = debounceWait > 0xFFFF ? 0xFFFF : debounceWait;
+
+   audit.head = (audit.head + 1) % TRANSITION_LOG_SIZE;
+   if (audit.count < TRANSITION_LOG_SIZE) audit.count++;
+
+   audit.residency[from] += now - audit.stateEnteredAt;
+   audit.stateEnteredAt = now;
+   audit.edgeCount[from][to]++;
+   audit.total++;
+ }
+
+ /*
+  * Record a pending change that was abandoned before its debounce expired
+  */
+ void recordCancelledTransition(SystemState target) {
+   ctx().transitionAudit.cancelled[target]++;
+ }
+
+ /*
+  * Time since the current state was entered, in ms (full 32-bit range)
+  */
+ unsigned long getTimeInState() {
+   return millis() - ctx().transitionAudit.stateEnteredAt;
+ }
+
+ /*
+  * Total time spent in a state, including the visit in progress
+  */
+ unsigned long getStateResidency(SystemState state) {
+   unsigned long residency = ctx().transitionAudit.residency[state];
+   if (state == ctx().currentState) {
+     residency += millis() - ctx().transitionAudit.stateEnteredAt;
+   }
+   return residency;
+ }
+
+ // Steps of the TRANSITIONS report; each recent record takes two steps
+ enum TransitionReportStep {
+   TRANSITIONS_HEADER,
+   TRANSITIONS_TOTAL,
+   TRANSITIONS_RESIDENCY_HEADER,
+   TRANSITIONS_RESIDENCY_FIRST,
+   TRANSITIONS_COUNTS_HEADER = TRANSITIONS_RESIDENCY_FIRST + STATE_COUNT,
+   TRANSITIONS_COUNTS_FIRST,
+   TRANSITIONS_CANCELLED_HEADER = TRANSITIONS_COUNTS_FIRST + STATE_COUNT * STATE_COUNT,
+   TRANSITIONS_CANCELLED_FIRST,
+   TRANSITIONS_RECENT_HEADER = TRANSITIONS_CANCELLED_FIRST + STATE_COUNT,
+   TRANSITIONS_RECENT_FIRST,
+   TRANSITIONS_FOOTER = TRANSITIONS_RECENT_FIRST + 2 * TRANSITION_LOG_SIZE
+ };
+
+ /*
+  * Transition history and statistics, one line per step; a recent
+  * record takes two lines so each fits a report chunk
+  */
+ static bool transitionReportStep(uint8_t step, ReportWriter& out) {
+   TransitionAudit& audit = ctx().transitionAudit;
+   unsigned long uptime = millis();
+
+   if (step >= TRANSITIONS_RESIDENCY_FIRST && step < TRANSITIONS_COUNTS_HEADER) {
+     SystemState s = (SystemState)(step - TRANSITIONS_RESIDENCY_FIRST);
+     unsigned long residency = getStateResidency(s);
+     out << stateToString(s) << F(": ") << residency / 1000 << F("s");
+     if (uptime > 0) {
+       out << F(" (") << fixed(residency * 100.0 / uptime, 1) << F("%)");
+     }
+     out << eol;
+     return true;
+   }
+
+   if (step >= TRANSITIONS_COUNTS_FIRST && step < TRANSITIONS_CANCELLED_HEADER) {
+     uint8_t from = (step - TRANSITIONS_COUNTS_FIRST) / STATE_COUNT;
+     uint8_t to = (step - TRANSITIONS_COUNTS_FIRST) % STATE_COUNT;
+     if (audit.edgeCount[from][to] > 0) {
+       out << stateToString((SystemState)from) << F(" -> ") << stateToString((SystemState)to)
+           << F(": ") << audit.edgeCount[from][to] << eol;
+     }
+     return true;
+   }
+
+   if (step >= TRANSITIONS_CANCELLED_FIRST && step < TRANSITIONS_RECENT_HEADER) {
+     SystemState s = (SystemState)(step - TRANSITIONS_CANCELLED_FIRST);
+     out << F("To ") << stateToString(s) << F(": ") << audit.cancelled[s]
+         << F(" (debounce ") << getStateDebounceTime(s) << F("ms)") << eol;
+     return true;
+   }
+
+   if (step >= TRANSITIONS_RECENT_FIRST && step < TRANSITIONS_FOOTER) {
+     // Oldest first; records added while the report is running push the
+     // window forward rather than repeating lines. A record's two lines are
+     // both written from the copy taken for the first, so they always match
+     if ((step - TRANSITIONS_RECENT_FIRST) % 2 == 0) {
+       uint8_t i = (step - TRANSITIONS_RECENT_FIRST) / 2;
+       audit.reportedValid = i < audit.count;
+       if (!audit.reportedValid) return true;
+       uint8_t index = (audit.head + TRANSITION_LOG_SIZE - audit.count + i) % TRANSITION_LOG_SIZE;
+       audit.reported = audit.log[index];
+       const TransitionRecord& record = audit.reported;
+       out << record.timestamp << F("ms ") << stateToString((SystemState)record.from)
+           << F(" -> ") << stateToString((SystemState)record.to)
+           << F(" waited ") << record.debounceWait << F("ms") << eol;
+     } else if (audit.reportedValid) {
+       out << F("  [") << triggerNames(audit.reported.triggers) << ']' << eol;
+     }
+     return true;
+   }
+
+   switch (step) {
+     case TRANSITIONS_HEADER:
+       out << F("\n=== STATE TRANSITIONS ===") << eol;
+       break;
+     case TRANSITIONS_TOTAL:
+       out << F("Total: ") << audit.total;
+       if (uptime >= 1000) {
+         out << F(" (") << fixed(audit.total * 3600000.0 / uptime, 1) << F("/h)");
+       }
+       out << eol;
+       break;
+     case TRANSITIONS_RESIDENCY_HEADER:
+       out << F("--- Time in State ---") << eol;
+       break;
+     case TRANSITIONS_COUNTS_HEADER:
+       out << F("--- Transition Counts ---") << eol;
+       break;
+     case TRANSITIONS_CANCELLED_HEADER:
+       out << F("--- Cancelled Pending ---") << eol;
+       break;
+     case TRANSITIONS_RECENT_HEADER:
+       out << F("--- Recent (oldest first) ---") << eol;
+       break;
+     case TRANSITIONS_FOOTER:
+       out << F("=========================\n") << eol;
+       break;
+     default:
+       return false;
+   }
+   return true;
+ }
+
+ /*
+  * Queue the TRANSITIONS report
+  */
+ void printTransitionReport() {
+   queueReport(transitionReportStep);
+ }
@@ -3,82 +3,166 @@
  */
 
  #include "utilities.h"
+ #include "sampling_policy.h"
+ #include "report_queue.h"
+ #include "transition_audit.h"
+ #include "system_context.h"
+
+ // State names live in flash; index matches SystemState
+ static const char stateNameIdle[] PROGMEM = "IDLE";
+ static const char stateNameMonitoring[] PROGMEM = "MONITORING";
+ static const char stateNameAlert[] PROGMEM = "ALERT";
+ static const char stateNameAlarm[] PROGMEM = "ALARM";
+ static const char* const stateNames[] PROGMEM = {
+   stateNameIdle,
+   stateNameMonitoring,
+   stateNameAlert,
+   stateNameAlarm
+ };
 
  /*
-  * Convert state enum to string for logging
+  * Convert state enum to a flash string for logging
   */
- String stateToString(SystemState state) {
-   switch (state) {
-     case IDLE: return "IDLE";
-     case MONITORING: return "MONITORING";
-     case ALERT: return "ALERT";
-     case ALARM: return "ALARM";
-     default: return "UNKNOWN";
+ const __FlashStringHelper* stateToString(SystemState state) {
+   if ((unsigned int)state >= sizeof(stateNames) / sizeof(stateNames[0])) {
+     return F("UNKNOWN");
    }
+   return (const __FlashStringHelper*)pgm_read_ptr(&stateNames[state]);
+ }
+ 
+ static const __FlashStringHelper* yesNo(bool value) {
+   return value ? F("YES") : F("NO");
+ }
+ 
+ // " (Last change: Ns ago)" line ending; a saturated stamp only gives a lower bound
+ static void printLastChange(ReportWriter& out, Stamp16 stamp) {
+   out << F(" (Last change: ");
+   if (stampSaturated(stamp)) out << '>';
+   out << stampElapsedMs(stamp) / 1000 << F("s ago)") << eol;
  }
  
+ // Steps of the STATUS report
+ enum StatusStep {
+   STATUS_HEADER,
+   STATUS_STATE,
+   STATUS_ARMED,
+   STATUS_ALARM_ACTIVE,
+   STATUS_LOG_LEVEL,
+   STATUS_SENSORS,
+   STATUS_MOTION,
+   STATUS_GAS_ALERT,
+   STATUS_TEMPERATURE,
+   STATUS_GAS_LEVEL,
+   STATUS_SAMPLING,
+   STATUS_CHANNEL_FIRST,
+   STATUS_SYSTEM_INFO = STATUS_CHANNEL_FIRST + ANALOG_CHANNEL_COUNT,
+   STATUS_UPTIME,
+   STATUS_STATE_TIME,
+   STATUS_ALARM_TIME,
+   STATUS_FOOTER
+ };
+ 
  /*
-  * Print comprehensive system status
+  * Comprehensive system status, one line per step
   */
- void printSystemStatus() {
-  Serial.println("\n=== SYSTEM STATUS ===");
-  Serial.print("State: "); Serial.print(stateToString(currentState));
-  
-  // Show pending state if different
-  if (pendingState != currentState) {
-    Serial.print(" (Pending: "); Serial.print(stateToString(pendingState)); Serial.print(")");
-  }
-  Serial.println();
-  
-  Serial.print("Armed: "); Serial.println(systemFlags.armed ? "YES" : "NO");
-  Serial.print("Alarm Active: "); Serial.println(systemFlags.alarmActive ? "YES" : "NO");
-  Serial.print("Log Level: ");
-  switch (systemFlags.logLevel) {
-    case 0: Serial.println("QUIET (0)"); break;
-    case 1: Serial.println("NORMAL (1)"); break;
-    case 2: Serial.println("VERBOSE (2)"); break;
-    default: Serial.println("UNKNOWN"); break;
-  }
-  
-  Serial.println("--- Sensors ---");
-  Serial.print("Motion: "); Serial.print(sensors.pir ? "ACTIVE" : "INACTIVE");
-  Serial.print(" (Last change: "); Serial.print((millis() - sensors.pirLastChange) / 1000); Serial.println("s ago)");
-  
-  Serial.print("Gas Alert: "); Serial.print(sensors.gasSafe ? "SAFE" : "DANGER");
-  Serial.print(" (Last change: "); Serial.print((millis() - sensors.gasLastChange) / 1000); Serial.println("s ago)");
-  
-  Serial.print("Temperature: "); Serial.print(sensors.temperature, 1); Serial.print("°C");
-  if (sensors.temperature > TEMP_HIGH_WARNING) {
-    Serial.print(" [HIGH WARNING]");
-  } else if (sensors.temperature < TEMP_LOW_WARNING) {
-    Serial.print(" [LOW WARNING]");
-  }
-  Serial.println();
-  
-  Serial.print("Gas Level: "); Serial.print(sensors.gasReading);
-  if (sensors.gasReading > GAS_WARNING) {
-    Serial.print(" [WARNING]");
+ static bool statusReportStep(uint8_t step, ReportWriter& out) {
+  if (step >= STATUS_CHANNEL_FIRST && step < STATUS_SYSTEM_INFO) {
+    printSamplingChannel((AnalogChannel)(step - STATUS_CHANNEL_FIRST), out);
+    return true;
   }
-  Serial.println();
   
-  Serial.println("--- System Info ---");
-  Serial.print("Uptime: "); 
-  unsigned long uptime = millis() / 1000;
-  Serial.print(uptime / 3600); Serial.print("h ");
-  Serial.print((uptime % 3600) / 60); Serial.print("m ");
-  Serial.print(uptime % 60); Serial.println("s");
-  
-  Serial.print("Time in State: "); 
-  unsigned long stateTime = (millis() - systemFlags.lastStateChange) / 1000;
-  Serial.print(stateTime); Serial.println("s");
-  
-  if (systemFlags.alarmActive) {
-    unsigned long alarmTime = (millis() - systemFlags.alarmStartTime) / 1000;
-    Serial.print("Alarm Duration: "); Serial.print(alarmTime); Serial.println("s");
+  switch (step) {
+    case STATUS_HEADER:
+      out << F("\n=== SYSTEM STATUS ===") << eol;
+      break;
+    case STATUS_STATE:
+      out << F("State: ") << stateToString(ctx().currentState);
+      // Show pending state if different
+      if (ctx().pendingState != ctx().currentState) {
+        out << F(" (Pending: ") << stateToString(ctx().pendingState) << F(")");
+      }
+      out << eol;
+      break;
+    case STATUS_ARMED:
+      out << F("Armed: ") << yesNo(ctx().systemFlags.armed) << eol;
+      break;
+    case STATUS_ALARM_ACTIVE:
+      out << F("Alarm Active: ") << yesNo(ctx().systemFlags.alarmActive) << eol;
+      break;
+    case STATUS_LOG_LEVEL:
+      out << F("Log Level: ");
+      switch (ctx().systemFlags.logLevel) {
+        case 0: out << F("QUIET (0)") << eol; break;
+        case 1: out << F("NORMAL (1)") << eol; break;
+        case 2: out << F("VERBOSE (2)") << eol; break;
+        default: out << F("UNKNOWN") << eol; break;
+      }
+      break;
+    case STATUS_SENSORS:
+      out << F("--- Sensors ---") << eol;
+      break;
+    case STATUS_MOTION:
+      out << F("Motion: ") << (ctx().sensors.pir ? F("ACTIVE") : F("INACTIVE"));
+      printLastChange(out, ctx().sensors.pirLastChange);
+      break;
+    case STATUS_GAS_ALERT:
+      out << F("Gas Alert: ") << (ctx().sensors.gasSafe ? F("SAFE") : F("DANGER"));
+      printLastChange(out, ctx().sensors.gasLastChange);
+      break;
+    case STATUS_TEMPERATURE:
+      out << F("Temperature: ") << ctx().sensors.temperature << F("°C");
+      if (ctx().sensors.temperature > TEMP_HIGH_WARNING) {
+        out << F(" [HIGH WARNING]");
+      } else if (ctx().sensors.temperature < TEMP_LOW_WARNING) {
+        out << F(" [LOW WARNING]");
+      }
+      out << eol;
+      break;
+    case STATUS_GAS_LEVEL:
+      out << F("Gas Level: ") << ctx().sensors.gasReading;
+      if (ctx().sensors.gasReading > GAS_WARNING) {
+        out << F(" [WARNING]");
+      }
+      out << eol;
+      break;
+    case STATUS_SAMPLING:
+      out << F("--- Sampling ---") << eol;
+      break;
+    case STATUS_SYSTEM_INFO:
+      out << F("--- System Info ---") << eol;
+      break;
+    case STATUS_UPTIME: {
+      unsigned long uptime = millis() / 1000;
+      out << F("Uptime: ") << uptime / 3600 << F("h ") << (uptime % 3600) / 60 << F("m ") << uptime % 60 << F("s") << eol;
+      break;
+    }
+    case STATUS_STATE_TIME: {
+      out << F("Time in State: ") << getTimeInState() / 1000 << F("s") << eol;
+      break;
+    }
+    case STATUS_ALARM_TIME:
+      if (ctx().systemFlags.alarmActive) {
+        // A saturated stamp only gives a lower bound, as in printLastChange()
+        out << F("Alarm Duration: ");
+        if (stampSaturated(ctx().systemFlags.alarmStartTime)) out << '>';
+        out << stampElapsedMs(ctx().systemFlags.alarmStartTime) / 1000 << F("s") << eol;
+      }
+      break;
+    case STATUS_FOOTER:
+      out << F("====================\n") << eol;
+      break;
+    default:
+      return false;
   }
-  
-  Serial.println("====================\n");
-}
+  return true;
+ }
+ 
+ /*
+  * Queue the comprehensive system status report
+  */
+ void printSystemStatus() {
+   queueReport(statusReportStep);
+ }
  
  /*
   * Provide periodic status updates
@@ -86,37 +170,31 @@
  void periodicStatusUpdate() {
    unsigned long currentTime = millis();
    
-   if (currentTime - lastSerialUpdate >= SERIAL_UPDATE_INTERVAL) {
+   if (currentTime - ctx().lastSerialUpdate >= SERIAL_UPDATE_INTERVAL) {
     bool shouldUpdate = false;
     
-    if (systemFlags.verboseLogging) {
+    if (ctx().systemFlags.verboseLogging) {
       shouldUpdate = true; // Always update in verbose mode
-    } else if (currentState == ALARM) {
+    } else if (ctx().currentState == ALARM) {
       shouldUpdate = true; // Always update during alarms
-    } else if (currentState == ALERT) {
+    } else if (ctx().currentState == ALERT) {
       shouldUpdate = true; // Update during alerts
-    } else if (currentState == MONITORING && systemFlags.logLevel >= 1) {
+    } else if (ctx().currentState == MONITORING && ctx().systemFlags.logLevel >= 1) {
       // Occasional updates while monitoring
-      static int updateCounter = 0;
-      updateCounter++;
-      if (updateCounter >= 6) { // Every 30 seconds (6 * 5 second intervals)
+      ctx().statusUpdateCounter++;
+      if (ctx().statusUpdateCounter >= 6) { // Every 30 seconds (6 * 5 second intervals)
         shouldUpdate = true;
-        updateCounter = 0;
+        ctx().statusUpdateCounter = 0;
       }
     }
     
     if (shouldUpdate) {
-       Serial.print("STATUS: ");
-       Serial.print(stateToString(currentState));
-       Serial.print(" | Motion: ");
-       Serial.print(sensors.pir ? "1" : "0");
-       Serial.print(" | Gas Danger: ");
-       Serial.print(sensors.gasSafe ? "0" : "1");
-       Serial.print(" | Temp: ");
-       Serial.print(sensors.temperature);
-       Serial.print("°C | Gas Reading: ");
-       Serial.println(sensors.gasReading);
+       ReportLine(Serial) << F("STATUS: ") << stateToString(ctx().currentState)
+                          << F(" | Motion: ") << (ctx().sensors.pir ? '1' : '0')
+                          << F(" | Gas Danger: ") << (ctx().sensors.gasSafe ? '0' : '1')
+                          << F(" | Temp: ") << ctx().sensors.temperature
+                          << F("°C | Gas Reading: ") << ctx().sensors.gasReading;
      }
-     lastSerialUpdate = currentTime;
+     ctx().lastSerialUpdate = currentTime;
    }
  }
\ No newline at end of file
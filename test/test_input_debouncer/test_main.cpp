@@ -0,0 +1,116 @@
+/*
+ * Unit tests for the bit-parallel port debouncer (input_debouncer.h)
+ * Run on the host with: pio test -e native-test
+ */
+
+ #include <unity.h>
+ #include "system_config.h"
+
+ static PortDebouncer port;
+
+ static void feed(uint8_t sample, uint8_t count) {
+   while (count--) debouncePort(port, sample);
+ }
+
+ void setUp() {
+   initPortDebouncer(port, 0x00);
+ }
+
+ void tearDown() {}
+
+ /*
+  * Runs of 1 to DEBOUNCE_SAMPLES - 1 samples are glitches: the debounced
+  * level holds and no edge is reported
+  */
+ void test_short_runs_are_ignored() {
+   for (uint8_t run = 1; run < DEBOUNCE_SAMPLES; run++) {
+     feed(0x01, run);
+     TEST_ASSERT_EQUAL_HEX8(0x00, port.state);
+     feed(0x00, 1);
+     TEST_ASSERT_EQUAL_HEX8(0x00, port.state);
+   }
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.rise);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.fall);
+ }
+
+ /*
+  * An agreeing sample resets the count, so two short runs back to back
+  * never add up to a toggle
+  */
+ void test_agreeing_sample_restarts_the_count() {
+   feed(0x01, DEBOUNCE_SAMPLES - 1);
+   feed(0x00, 1);
+   feed(0x01, DEBOUNCE_SAMPLES - 1);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.rise);
+ }
+
+ /*
+  * The output toggles on the DEBOUNCE_SAMPLES-th consecutive sample,
+  * not before
+  */
+ void test_toggles_on_fourth_consecutive_sample() {
+   TEST_ASSERT_EQUAL(4, DEBOUNCE_SAMPLES);
+   feed(0x01, 3);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.state);
+   feed(0x01, 1);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.state);
+
+   // Holding the new level is stable and reports nothing further
+   port.rise = 0;
+   feed(0x01, 10);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.rise);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.fall);
+ }
+
+ /*
+  * A debounced 0->1 change sets rise and a 1->0 change sets fall, each
+  * only for the bit that moved; flags accumulate until the reader clears them
+  */
+ void test_rise_and_fall_edges() {
+   feed(0x05, 4);
+   TEST_ASSERT_EQUAL_HEX8(0x05, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x05, port.rise);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.fall);
+
+   feed(0x04, 4);
+   TEST_ASSERT_EQUAL_HEX8(0x04, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x05, port.rise);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.fall);
+
+   port.rise = 0;
+   port.fall = 0;
+   feed(0x00, 4);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x00, port.rise);
+   TEST_ASSERT_EQUAL_HEX8(0x04, port.fall);
+ }
+
+ /*
+  * Each bit keeps its own counter: a glitch on one input does not delay
+  * or advance a change on another
+  */
+ void test_inputs_are_independent() {
+   feed(0x01, 2);
+   feed(0x03, 2);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.state);
+   feed(0x01, 1);
+   feed(0x03, 2);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.state);
+   feed(0x03, 1);
+   TEST_ASSERT_EQUAL_HEX8(0x01, port.state);
+   feed(0x03, 1);
+   TEST_ASSERT_EQUAL_HEX8(0x03, port.state);
+   TEST_ASSERT_EQUAL_HEX8(0x03, port.rise);
+ }
+
+ int main() {
+   UNITY_BEGIN();
+   RUN_TEST(test_short_runs_are_ignored);
+   RUN_TEST(test_agreeing_sample_restarts_the_count);
+   RUN_TEST(test_toggles_on_fourth_consecutive_sample);
+   RUN_TEST(test_rise_and_fall_edges);
+   RUN_TEST(test_inputs_are_independent);
+   return UNITY_END();
+ }
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Compare two captured microbenchmark runs and flag regressions.
+
+Usage: bench_compare.py BASELINE CANDIDATE [--threshold PERCENT]
+
+Each input is raw serial (or stdout) output from the uno-bench or
+native-bench build; only BENCH_BEGIN/BENCH/BENCH_ERROR lines are read, so
+the capture may contain other traffic. Exits with status 1 if any kernel's
+per-iteration cost grew by more than the threshold (default 5%), or if the
+candidate run reported a BENCH_ERROR.
+"""
+
+import argparse
+import sys
+
+
+def load_run(path):
+    """Return (target, unit, {kernel: per_iteration}, [error]) from a capture."""
+    target, unit, results, errors = None, None, {}, []
+    with open(path, encoding="utf-8", errors="replace") as capture:
+        for line in capture:
+            fields = line.strip().split(",")
+            if fields[0] == "BENCH_BEGIN" and len(fields) == 3:
+                target, unit = fields[1], fields[2]
+            elif fields[0] == "BENCH" and len(fields) == 5:
+                results[fields[1]] = float(fields[4])
+            elif fields[0] == "BENCH_ERROR":
+                errors.append(",".join(fields[1:]))
+    if not results:
+        sys.exit(f"error: no BENCH records in {path}")
+    return target, unit, results, errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold in percent (default 5)")
+    args = parser.parse_args()
+
+    base_target, base_unit, base, _ = load_run(args.baseline)
+    cand_target, cand_unit, cand, errors = load_run(args.candidate)
+    if (base_target, base_unit) != (cand_target, cand_unit):
+        sys.exit(f"error: cannot compare {base_target}/{base_unit} "
+                 f"against {cand_target}/{cand_unit}")
+
+    regressions = 0
+    print(f"{'kernel':<28}{'baseline':>12}{'candidate':>12}{'delta':>9}  ({base_unit}/iter)")
+    for kernel in sorted(set(base) | set(cand)):
+        if kernel not in base or kernel not in cand:
+            side = "candidate" if kernel not in cand else "baseline"
+            print(f"{kernel:<28}  missing from {side}")
+            continue
+        before, after = base[kernel], cand[kernel]
+        delta = (after - before) / before * 100.0 if before else 0.0
+        flag = ""
+        if delta > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif delta < -args.threshold:
+            flag = "  improved"
+        print(f"{kernel:<28}{before:>12.1f}{after:>12.1f}{delta:>+8.1f}%{flag}")
+
+    for error in errors:
+        print(f"candidate error: {error}")
+    if regressions:
+        print(f"\n{regressions} kernel(s) regressed by more than {args.threshold:g}%")
+        return 1
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,358 @@
+/*
+ * Offline analytics for captured serial logs
+ *
+ *   log_analytics [--threads N] [--summary OUT.lsum] [SITE=]LOG...
+ *   log_analytics --query SUMMARY.lsum [report|timeline|alarms|sensors] [--site SITE]
+ *
+ * Each LOG argument is memory-mapped and split into newline-aligned chunks
+ * that a pool of threads parses in parallel. A site is named after its
+ * file (without directory or extension) unless given as SITE=path; several
+ * files for one site are taken in argument order. Results go to stdout and,
+ * with --summary, to a compact columnar file that --query reads back
+ * without touching the logs again.
+ */
+
+ #include "log_parser.h"
+ #include "site_summary.h"
+ #include "summary_file.h"
+
+ #include <atomic>
+ #include <thread>
+ #include <string>
+ #include <vector>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+
+ // Chunks per thread, so uneven chunks still balance
+ #define CHUNKS_PER_THREAD 8
+ #define MIN_CHUNK_BYTES (4UL << 20)
+ #define MAX_CHUNK_BYTES (256UL << 20)
+
+ /*
+  * Read-only memory mapping of a whole file
+  */
+ class MappedFile {
+   public:
+     MappedFile() : data(NULL), size(0) {}
+     MappedFile(const MappedFile&) = delete;
+     MappedFile& operator=(const MappedFile&) = delete;
+     ~MappedFile() {
+       if (data) munmap((void*)data, size);
+     }
+
+     bool open(const char* path) {
+       int fd = ::open(path, O_RDONLY);
+       if (fd < 0) return false;
+       struct stat info;
+       if (fstat(fd, &info) != 0) {
+         close(fd);
+         return false;
+       }
+       size = info.st_size;
+       if (size > 0) {
+         void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (mapping == MAP_FAILED) {
+           close(fd);
+           return false;
+         }
+         data = (const char*)mapping;
+         madvise(mapping, size, MADV_SEQUENTIAL);
+       }
+       close(fd);
+       return true;
+     }
+
+     const char* data;
+     size_t size;
+ };
+
+ struct LogInput {
+   std::string site;
+   std::string path;
+ };
+
+ struct ChunkTask {
+   size_t input;      // index into inputs
+   const char* begin;
+   const char* end;
+ };
+
+ static std::string siteNameFromPath(const std::string& path) {
+   size_t slash = path.find_last_of('/');
+   std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+   size_t dot = name.find('.');
+   return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+ }
+
+ /*
+  * Split a mapped file into chunks that end on line boundaries
+  */
+ static void splitIntoChunks(size_t input, const MappedFile& file, size_t chunkBytes, std::vector<ChunkTask>& tasks) {
+   const char* p = file.data;
+   const char* end = file.data + file.size;
+   while (p < end) {
+     const char* chunkEnd = (size_t)(end - p) <= chunkBytes ? end : p + chunkBytes;
+     if (chunkEnd < end) {
+       const char* newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+       chunkEnd = newline ? newline + 1 : end;
+     }
+     ChunkTask task = {input, p, chunkEnd};
+     tasks.push_back(task);
+     p = chunkEnd;
+   }
+ }
+
+ /*
+  * Parse all chunks on a pool of threads pulling from a shared index
+  */
+ static void parseChunks(const std::vector<ChunkTask>& tasks, std::vector<ChunkResult>& results, unsigned threads) {
+   std::atomic<size_t> next(0);
+   std::vector<std::thread> pool;
+   for (unsigned t = 0; t < threads; t++) {
+     pool.push_back(std::thread([&]() {
+       for (size_t i = next++; i < tasks.size(); i = next++) {
+         parseChunk(tasks[i].begin, tasks[i].end, results[i]);
+       }
+     }));
+   }
+   for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+ }
+
+ /*
+  * Render a timestamp: calendar time for dated logs, day + time otherwise
+  */
+ static const char* formatTime(int64_t time, bool timeOfDay, char* buffer, size_t size) {
+   if (time == NO_TIME) {
+     snprintf(buffer, size, "-");
+   } else if (timeOfDay) {
+     int64_t ms = time % MS_PER_DAY;
+     snprintf(buffer, size, "day %lld %02d:%02d:%02d.%03d", (long long)(time / MS_PER_DAY),
+              (int)(ms / 3600000), (int)(ms / 60000 % 60), (int)(ms / 1000 % 60), (int)(ms % 1000));
+   } else {
+     time_t seconds = (time_t)(time / 1000);
+     struct tm parts;
+     gmtime_r(&seconds, &parts);
+     size_t used = strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &parts);
+     snprintf(buffer + used, size - used, ".%03d", (int)(time % 1000));
+   }
+   return buffer;
+ }
+
+ static void printTriggers(uint8_t triggers) {
+   if (triggers == 0) {
+     printf("None");
+     return;
+   }
+   bool first = true;
+   for (uint8_t bit = 0; bit < LOG_TRIGGER_COUNT; bit++) {
+     if (!(triggers & (1 << bit))) continue;
+     printf("%s%s", first ? "" : " ", logTriggerName(bit));
+     first = false;
+   }
+ }
+
+ static void printDistribution(const char* label, const uint64_t* hist, int bins, int offset) {
+   uint64_t samples = histogramTotal(hist, bins);
+   if (samples == 0) {
+     printf("  %s: no readings\n", label);
+     return;
+   }
+   printf("  %s: n=%llu min %d p50 %d p95 %d max %d mean %.1f\n", label, (unsigned long long)samples,
+          histogramPercentile(hist, bins, 0.0) + offset, histogramPercentile(hist, bins, 0.5) + offset,
+          histogramPercentile(hist, bins, 0.95) + offset, histogramPercentile(hist, bins, 1.0) + offset,
+          histogramMean(hist, bins) + offset);
+ }
+
+ static void printSiteReport(const SiteSummary& site) {
+   char first[48], last[48];
+   const LogCounters& counts = site.counts;
+
+   printf("=== %s ===\n", site.name.c_str());
+   printf("Lines: %llu  Span: %s .. %s\n", (unsigned long long)counts.lines,
+          formatTime(site.firstTime, site.timeOfDay, first, sizeof(first)),
+          formatTime(site.lastTime, site.timeOfDay, last, sizeof(last)));
+   uint64_t changes = 0;
+   for (int from = 0; from < LOG_STATE_COUNT; from++) {
+     for (int to = 0; to < LOG_STATE_COUNT; to++) changes += site.edgeCount[from][to];
+   }
+   printf("Boots: %llu  Transitions: %llu  Resyncs: %llu\n", (unsigned long long)counts.boots,
+          (unsigned long long)changes, (unsigned long long)site.resyncs);
+   printf("Alarms: %llu (fast path %llu)  Motion alerts: %llu  Gas danger: %llu\n",
+          (unsigned long long)site.alarms, (unsigned long long)counts.fastPathAlarms,
+          (unsigned long long)counts.motionAlerts, (unsigned long long)counts.gasDanger);
+   printf("Warnings: %llu (temperature %llu, gas %llu)\n", (unsigned long long)counts.warningLines,
+          (unsigned long long)counts.tempWarnings, (unsigned long long)counts.gasWarnings);
+
+   uint64_t tracked = 0;
+   for (int s = 0; s < LOG_STATE_COUNT; s++) tracked += site.timeInState[s];
+   printf("Time in state:\n");
+   for (int s = 0; s < LOG_STATE_COUNT; s++) {
+     if (tracked == 0) {
+       printf("  %s: n/a (no timestamps)\n", logStateName(s));
+       continue;
+     }
+     printf("  %s: %.2fh (%.1f%%)\n", logStateName(s), site.timeInState[s] / 3600000.0,
+            site.timeInState[s] * 100.0 / tracked);
+   }
+
+   printf("Transition counts:\n");
+   for (int from = 0; from < LOG_STATE_COUNT; from++) {
+     for (int to = 0; to < LOG_STATE_COUNT; to++) {
+       if (site.edgeCount[from][to] == 0) continue;
+       printf("  %s -> %s: %llu\n", logStateName(from), logStateName(to),
+              (unsigned long long)site.edgeCount[from][to]);
+     }
+   }
+
+   printf("Sensor readings:\n");
+   printDistribution("Temperature (C)", site.tempHist, TEMP_HIST_BINS, TEMP_HIST_MIN);
+   printDistribution("Gas (ADC)", site.gasHist, GAS_HIST_BINS, 0);
+   printf("\n");
+ }
+
+ static const char* const timelineKindNames[] = {"", " (command)", " (boot)", " (resync)"};
+
+ static void printTimeline(const SiteSummary& site, bool alarmsOnly) {
+   char when[48];
+   for (size_t i = 0; i < site.timeline.size(); i++) {
+     const TimelineEntry& entry = site.timeline[i];
+     if (alarmsOnly && entry.to != LOG_ALARM) continue;
+     printf("%s %s %s -> %s%s [", site.name.c_str(), formatTime(entry.time, site.timeOfDay, when, sizeof(when)),
+            logStateName(entry.from), logStateName(entry.to), timelineKindNames[entry.kind & 3]);
+     printTriggers(entry.triggers);
+     printf("]\n");
+   }
+ }
+
+ static void printSensors(const SiteSummary& site) {
+   printf("=== %s ===\n", site.name.c_str());
+   printf("Temperature (C) histogram:\n");
+   for (int i = 0; i < TEMP_HIST_BINS; i++) {
+     if (site.tempHist[i]) printf("  %d: %llu\n", i + TEMP_HIST_MIN, (unsigned long long)site.tempHist[i]);
+   }
+   printf("Gas (ADC) histogram, 32-count bins:\n");
+   for (int i = 0; i < GAS_HIST_BINS; i += 32) {
+     uint64_t total = 0;
+     for (int j = i; j < i + 32; j++) total += site.gasHist[j];
+     if (total) printf("  %d-%d: %llu\n", i, i + 31, (unsigned long long)total);
+   }
+   printf("\n");
+ }
+
+ static int usage() {
+   fprintf(stderr,
+           "usage: log_analytics [--threads N] [--summary OUT.lsum] [SITE=]LOG...\n"
+           "       log_analytics --query SUMMARY.lsum [report|timeline|alarms|sensors] [--site SITE]\n");
+   return 2;
+ }
+
+ static int runQuery(const char* path, const char* view, const char* siteFilter) {
+   std::vector<SiteSummary> sites;
+   if (!readSummaryFile(path, sites)) {
+     fprintf(stderr, "error: cannot read summary %s\n", path);
+     return 1;
+   }
+   for (size_t s = 0; s < sites.size(); s++) {
+     if (siteFilter && sites[s].name != siteFilter) continue;
+     if (strcmp(view, "report") == 0) printSiteReport(sites[s]);
+     else if (strcmp(view, "timeline") == 0) printTimeline(sites[s], false);
+     else if (strcmp(view, "alarms") == 0) printTimeline(sites[s], true);
+     else if (strcmp(view, "sensors") == 0) printSensors(sites[s]);
+     else return usage();
+   }
+   return 0;
+ }
+
+ int main(int argc, char** argv) {
+   unsigned threads = std::thread::hardware_concurrency();
+   const char* summaryPath = NULL;
+   const char* queryPath = NULL;
+   const char* queryView = "report";
+   const char* siteFilter = NULL;
+   std::vector<LogInput> inputs;
+
+   for (int i = 1; i < argc; i++) {
+     if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+       threads = atoi(argv[++i]);
+     } else if (strcmp(argv[i], "--summary") == 0 && i + 1 < argc) {
+       summaryPath = argv[++i];
+     } else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+       queryPath = argv[++i];
+     } else if (strcmp(argv[i], "--site") == 0 && i + 1 < argc) {
+       siteFilter = argv[++i];
+     } else if (argv[i][0] == '-') {
+       return usage();
+     } else if (queryPath) {
+       queryView = argv[i];
+     } else {
+       inputs.push_back(LogInput());
+       std::string arg = argv[i];
+       size_t equals = arg.find('=');
+       inputs.back().path = equals == std::string::npos ? arg : arg.substr(equals + 1);
+       inputs.back().site = equals == std::string::npos ? siteNameFromPath(arg) : arg.substr(0, equals);
+     }
+   }
+   if (threads == 0) threads = 1;
+
+   if (queryPath) return runQuery(queryPath, queryView, siteFilter);
+   if (inputs.empty()) return usage();
+
+   std::vector<MappedFile> files(inputs.size());
+   size_t totalBytes = 0;
+   for (size_t i = 0; i < inputs.size(); i++) {
+     if (!files[i].open(inputs[i].path.c_str())) {
+       fprintf(stderr, "error: cannot map %s\n", inputs[i].path.c_str());
+       return 1;
+     }
+     totalBytes += files[i].size;
+   }
+
+   size_t chunkBytes = totalBytes / ((size_t)threads * CHUNKS_PER_THREAD);
+   if (chunkBytes < MIN_CHUNK_BYTES) chunkBytes = MIN_CHUNK_BYTES;
+   if (chunkBytes > MAX_CHUNK_BYTES) chunkBytes = MAX_CHUNK_BYTES;
+
+   std::vector<ChunkTask> tasks;
+   for (size_t i = 0; i < inputs.size(); i++) splitIntoChunks(i, files[i], chunkBytes, tasks);
+
+   struct timespec start, parsed;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   std::vector<ChunkResult> results(tasks.size());
+   parseChunks(tasks, results, threads);
+   clock_gettime(CLOCK_MONOTONIC, &parsed);
+
+   // Fold chunks into sites in first-seen site order, keeping log order
+   std::vector<std::string> siteOrder;
+   for (size_t i = 0; i < inputs.size(); i++) {
+     bool known = false;
+     for (size_t s = 0; s < siteOrder.size(); s++) known |= siteOrder[s] == inputs[i].site;
+     if (!known) siteOrder.push_back(inputs[i].site);
+   }
+   std::vector<SiteSummary> sites;
+   for (size_t s = 0; s < siteOrder.size(); s++) {
+     SiteBuilder builder(siteOrder[s]);
+     for (size_t t = 0; t < tasks.size(); t++) {
+       if (inputs[tasks[t].input].site == siteOrder[s]) builder.addChunk(results[t]);
+     }
+     sites.push_back(builder.finish());
+   }
+
+   for (size_t s = 0; s < sites.size(); s++) {
+     if (!siteFilter || sites[s].name == siteFilter) printSiteReport(sites[s]);
+   }
+
+   double seconds = (parsed.tv_sec - start.tv_sec) + (parsed.tv_nsec - start.tv_nsec) / 1e9;
+   fprintf(stderr, "Parsed %.1f MB in %zu chunks on %u threads: %.3fs (%.0f MB/s)\n", totalBytes / 1e6,
+           tasks.size(), threads, seconds, seconds > 0 ? totalBytes / 1e6 / seconds : 0.0);
+
+   if (summaryPath && !writeSummaryFile(summaryPath, sites)) {
+     fprintf(stderr, "error: cannot write summary %s\n", summaryPath);
+     return 1;
+   }
+   return 0;
+ }
@@ -0,0 +1,315 @@
+/*
+ * Log Parser implementation
+ * Lines are matched by prefix with no allocation; numbers are parsed in
+ * place. A line may start with a capture timestamp, either a date and time
+ * ("2025-07-19 20:11:41.123", optionally bracketed or with a 'T') or a time
+ * of day alone as written by the PlatformIO monitor time filter
+ * ("20:11:41.123 > ").
+ */
+
+ #include "log_parser.h"
+ #include <string.h>
+
+ static const char* const stateNames[LOG_STATE_COUNT] = {"IDLE", "MONITORING", "ALERT", "ALARM"};
+ static const char* const triggerNames[LOG_TRIGGER_COUNT] = {
+   "Motion", "GasDanger", "GasHigh", "TempHigh", "TempLow", "Command"
+ };
+
+ const char* logStateName(uint8_t state) {
+   return state < LOG_STATE_COUNT ? stateNames[state] : "UNKNOWN";
+ }
+
+ const char* logTriggerName(uint8_t bit) {
+   return bit < LOG_TRIGGER_COUNT ? triggerNames[bit] : "?";
+ }
+
+ template <size_t N>
+ static bool startsWith(const char* p, const char* end, const char (&prefix)[N]) {
+   return (size_t)(end - p) >= N - 1 && memcmp(p, prefix, N - 1) == 0;
+ }
+
+ template <size_t N>
+ static const char* findText(const char* p, const char* end, const char (&text)[N]) {
+   const void* found = memmem(p, end - p, text, N - 1);
+   return found ? (const char*)found + (N - 1) : NULL;
+ }
+
+ static bool parseFixedDigits(const char* p, int count, int& value) {
+   value = 0;
+   for (int i = 0; i < count; i++) {
+     if (p[i] < '0' || p[i] > '9') return false;
+     value = value * 10 + (p[i] - '0');
+   }
+   return true;
+ }
+
+ static bool parseInt(const char*& p, const char* end, long& value) {
+   bool negative = false;
+   if (p < end && *p == '-') {
+     negative = true;
+     p++;
+   }
+   if (p >= end || *p < '0' || *p > '9') return false;
+   long result = 0;
+   while (p < end && *p >= '0' && *p <= '9') {
+     result = result * 10 + (*p - '0');
+     p++;
+   }
+   value = negative ? -result : result;
+   return true;
+ }
+
+ // Days since 1970-01-01 for a proleptic Gregorian date
+ static int64_t daysFromCivil(int year, int month, int day) {
+   year -= month <= 2;
+   int64_t era = (year >= 0 ? year : year - 399) / 400;
+   int64_t yearOfEra = year - era * 400;
+   int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+   int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+   return era * 146097 + dayOfEra - 719468;
+ }
+
+ /*
+  * Parse "HH:MM:SS[.fff]" at p into ms since midnight
+  */
+ static bool parseTimeOfDay(const char*& p, const char* end, int64_t& ms) {
+   int hours, minutes, seconds;
+   if (end - p < 8 || p[2] != ':' || p[5] != ':') return false;
+   if (!parseFixedDigits(p, 2, hours) || !parseFixedDigits(p + 3, 2, minutes) ||
+       !parseFixedDigits(p + 6, 2, seconds)) return false;
+   p += 8;
+
+   int fraction = 0;
+   if (p < end && (*p == '.' || *p == ',')) {
+     p++;
+     int digits = 0;
+     while (p < end && *p >= '0' && *p <= '9') {
+       if (digits < 3) fraction = fraction * 10 + (*p - '0');
+       digits++;
+       p++;
+     }
+     for (; digits < 3; digits++) fraction *= 10;
+   }
+   ms = ((hours * 60LL + minutes) * 60 + seconds) * 1000 + fraction;
+   return true;
+ }
+
+ /*
+  * Strip a leading capture timestamp, if any
+  */
+ static bool parseTimestamp(const char*& p, const char* end, int64_t& time, bool& timeOfDay) {
+   const char* q = p;
+   if (q < end && *q == '[') q++;
+
+   int year, month, day;
+   if (end - q >= 19 && q[4] == '-' && q[7] == '-' && (q[10] == ' ' || q[10] == 'T') &&
+       parseFixedDigits(q, 4, year) && parseFixedDigits(q + 5, 2, month) && parseFixedDigits(q + 8, 2, day)) {
+     const char* t = q + 11;
+     int64_t ms;
+     if (!parseTimeOfDay(t, end, ms)) return false;
+     time = daysFromCivil(year, month, day) * MS_PER_DAY + ms;
+     timeOfDay = false;
+     q = t;
+     if (q < end && *q == 'Z') q++;
+   } else {
+     int64_t ms;
+     if (!parseTimeOfDay(q, end, ms)) return false;
+     time = ms;
+     timeOfDay = true;
+   }
+
+   // Separator between the capture timestamp and the firmware line
+   while (q < end && (*q == ' ' || *q == '\t' || *q == ']' || *q == '>' || *q == '|' || *q == '-')) q++;
+   p = q;
+   return true;
+ }
+
+ /*
+  * Match a state name at p, advancing past it
+  */
+ static uint8_t parseStateName(const char*& p, const char* end) {
+   for (uint8_t s = 0; s < LOG_STATE_COUNT; s++) {
+     size_t len = strlen(stateNames[s]);
+     if ((size_t)(end - p) >= len && memcmp(p, stateNames[s], len) == 0 &&
+         (p + len == end || p[len] == ' ')) {
+       p += len;
+       return s;
+     }
+   }
+   return LOG_STATE_UNKNOWN;
+ }
+
+ static uint8_t parseTriggerNames(const char* p, const char* end) {
+   uint8_t mask = 0;
+   while (p < end) {
+     while (p < end && *p == ' ') p++;
+     const char* word = p;
+     while (p < end && *p != ' ') p++;
+     for (uint8_t bit = 0; bit < LOG_TRIGGER_COUNT; bit++) {
+       size_t len = strlen(triggerNames[bit]);
+       if ((size_t)(p - word) == len && memcmp(word, triggerNames[bit], len) == 0) {
+         mask |= 1 << bit;
+       }
+     }
+   }
+   return mask;
+ }
+
+ // Parse state carried from line to line within one chunk
+ struct ChunkParser {
+   ChunkResult& result;
+   int64_t dayOffset;          // chunk-local days for time-of-day stamps
+   int64_t lastRawTime;
+   uint8_t knownState;         // last state the chunk's events imply
+
+   explicit ChunkParser(ChunkResult& result)
+     : result(result), dayOffset(0), lastRawTime(NO_TIME), knownState(LOG_STATE_UNKNOWN) {}
+
+   void addEvent(int64_t time, uint8_t kind, uint8_t from, uint8_t to, uint8_t triggers) {
+     LogEvent event = {time, kind, from, to, triggers};
+     result.events.push_back(event);
+   }
+
+   void addReadings(long temperature, bool haveTemperature, long gas, bool haveGas) {
+     if (haveTemperature) {
+       long bin = temperature - TEMP_HIST_MIN;
+       if (bin < 0) bin = 0;
+       if (bin >= TEMP_HIST_BINS) bin = TEMP_HIST_BINS - 1;
+       result.tempHist[bin]++;
+     }
+     if (haveGas) {
+       if (gas < 0) gas = 0;
+       if (gas >= GAS_HIST_BINS) gas = GAS_HIST_BINS - 1;
+       result.gasHist[gas]++;
+     }
+   }
+
+   int64_t lineTime(const char*& p, const char* end) {
+     int64_t raw;
+     bool timeOfDay;
+     if (!parseTimestamp(p, end, raw, timeOfDay)) return NO_TIME;
+
+     if (timeOfDay) {
+       // A jump back of more than 12 hours is taken as midnight passing
+       if (lastRawTime != NO_TIME && raw < lastRawTime - MS_PER_DAY / 2) dayOffset += MS_PER_DAY;
+       lastRawTime = raw;
+       result.timeOfDay = true;
+     }
+     int64_t time = raw + (timeOfDay ? dayOffset : 0);
+     if (result.firstTime == NO_TIME) result.firstTime = time;
+     result.lastTime = time;
+     return time;
+   }
+
+   void parseLine(const char* p, const char* end) {
+     if (end > p && end[-1] == '\r') end--;
+     result.counts.lines++;
+
+     int64_t time = lineTime(p, end);
+     if (p >= end) return;
+
+     switch (*p) {
+       case 'S':
+         if (startsWith(p, end, "STATE: ")) {
+           result.counts.stateLines++;
+           const char* q = p + 7;
+           uint8_t from = parseStateName(q, end);
+           if (from == LOG_STATE_UNKNOWN || !startsWith(q, end, " -> ")) return;
+           q += 4;
+           uint8_t to = parseStateName(q, end);
+           if (to == LOG_STATE_UNKNOWN) return;
+           addEvent(time, EVENT_TRANSITION, from, to, 0);
+           knownState = to;
+         } else if (startsWith(p, end, "SENSOR: ")) {
+           result.counts.sensorLines++;
+           const char* q = p + 8;
+           if (startsWith(q, end, "Temperature = ")) {
+             q += 14;
+             long temperature = 0, gas = 0;
+             bool haveTemperature = parseInt(q, end, temperature);
+             const char* g = findText(q, end, "Gas = ");
+             bool haveGas = g && parseInt(g, end, gas);
+             addReadings(temperature, haveTemperature, gas, haveGas);
+           } else if (startsWith(q, end, "PIR detector = ACTIVE")) {
+             result.counts.motionActive++;
+           } else if (startsWith(q, end, "Gas sensor = DANGER")) {
+             result.counts.gasDanger++;
+           }
+         } else if (startsWith(p, end, "STATUS: ")) {
+           result.counts.statusLines++;
+           const char* q = p + 8;
+           uint8_t state = parseStateName(q, end);
+           long temperature = 0, gas = 0;
+           const char* t = findText(q, end, "Temp: ");
+           bool haveTemperature = t && parseInt(t, end, temperature);
+           const char* g = findText(q, end, "Gas Reading: ");
+           bool haveGas = g && parseInt(g, end, gas);
+           addReadings(temperature, haveTemperature, gas, haveGas);
+           // Only a state the chunk does not already imply is worth an event
+           if (state != LOG_STATE_UNKNOWN && state != knownState) {
+             addEvent(time, EVENT_OBSERVED, LOG_STATE_UNKNOWN, state, 0);
+             knownState = state;
+           }
+         } else if (startsWith(p, end, "SYSTEM: Armed")) {
+           addEvent(time, EVENT_COMMAND, LOG_STATE_UNKNOWN, LOG_MONITORING, 0);
+           knownState = LOG_MONITORING;
+         } else if (startsWith(p, end, "SYSTEM: Disarmed")) {
+           addEvent(time, EVENT_COMMAND, LOG_STATE_UNKNOWN, LOG_IDLE, 0);
+           knownState = LOG_IDLE;
+         }
+         break;
+
+       case 'T':
+         if (startsWith(p, end, "TRIGGERS: ")) {
+           addEvent(time, EVENT_TRIGGERS, LOG_STATE_UNKNOWN, LOG_STATE_UNKNOWN, parseTriggerNames(p + 10, end));
+         }
+         break;
+
+       case 'W':
+         if (startsWith(p, end, "WARNING: ")) {
+           result.counts.warningLines++;
+           if (startsWith(p + 9, end, "Temperature")) result.counts.tempWarnings++;
+           else if (startsWith(p + 9, end, "Gas level")) result.counts.gasWarnings++;
+         }
+         break;
+
+       case 'A':
+         if (startsWith(p, end, "ALERT: Motion detected")) {
+           result.counts.motionAlerts++;
+         } else if (startsWith(p, end, "ALERT: Critical trigger")) {
+           result.counts.fastPathAlarms++;
+         }
+         break;
+
+       case '=':
+         if (startsWith(p, end, "=== Home Monitoring System Initialising")) {
+           result.counts.boots++;
+           addEvent(time, EVENT_BOOT, LOG_STATE_UNKNOWN, LOG_IDLE, 0);
+           knownState = LOG_IDLE;
+         }
+         break;
+     }
+   }
+ };
+
+ /*
+  * Parse the complete lines in [begin, end)
+  */
+ void parseChunk(const char* begin, const char* end, ChunkResult& result) {
+   memset(&result.counts, 0, sizeof(result.counts));
+   memset(result.tempHist, 0, sizeof(result.tempHist));
+   memset(result.gasHist, 0, sizeof(result.gasHist));
+   result.events.clear();
+   result.firstTime = NO_TIME;
+   result.lastTime = NO_TIME;
+   result.timeOfDay = false;
+
+   ChunkParser parser(result);
+   const char* line = begin;
+   while (line < end) {
+     const char* newline = (const char*)memchr(line, '\n', end - line);
+     const char* lineEnd = newline ? newline : end;
+     parser.parseLine(line, lineEnd);
+     line = lineEnd + 1;
+   }
+ }
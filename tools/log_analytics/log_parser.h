@@ -0,0 +1,88 @@
+/*
+ * Log Parser header declares the line parser for captured serial logs
+ *
+ * A log is split into newline-aligned chunks that are parsed independently
+ * (and in parallel); each chunk yields counters, sensor histograms and an
+ * ordered list of state events. Resolving events into a timeline needs the
+ * state carried over from earlier chunks, so that happens afterwards in
+ * site_summary.cpp.
+ */
+
+ #ifndef LOG_PARSER_H
+ #define LOG_PARSER_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include <vector>
+
+ // Firmware SystemState values, in the same order
+ enum LogState : uint8_t {
+   LOG_IDLE,
+   LOG_MONITORING,
+   LOG_ALERT,
+   LOG_ALARM,
+   LOG_STATE_COUNT,
+   LOG_STATE_UNKNOWN = 0xFF
+ };
+
+ // Firmware TRIGGER_* bits, in the same order
+ #define LOG_TRIGGER_COUNT 6
+
+ // Sensor histograms: 1 °C bins from TEMP_HIST_MIN, raw gas ADC counts
+ #define TEMP_HIST_MIN -55
+ #define TEMP_HIST_BINS 206
+ #define GAS_HIST_BINS 1024
+
+ // Timestamp of a line that had none
+ #define NO_TIME INT64_MIN
+
+ #define MS_PER_DAY 86400000LL
+
+ enum EventKind : uint8_t {
+   EVENT_TRANSITION,   // STATE: A -> B
+   EVENT_COMMAND,      // ARM/DISARM, which the firmware logs without a STATE line
+   EVENT_TRIGGERS,     // TRIGGERS: line following a transition
+   EVENT_OBSERVED,     // state seen in a STATUS line
+   EVENT_BOOT          // firmware start banner
+ };
+
+ struct LogEvent {
+   int64_t time;       // ms (epoch, or time of day plus chunk-local days); NO_TIME if unknown
+   uint8_t kind;       // EventKind
+   uint8_t from;       // LogState, LOG_STATE_UNKNOWN when the line does not say
+   uint8_t to;         // LogState
+   uint8_t triggers;   // trigger bit mask for EVENT_TRIGGERS
+ };
+
+ struct LogCounters {
+   uint64_t lines;
+   uint64_t stateLines;
+   uint64_t sensorLines;
+   uint64_t statusLines;
+   uint64_t warningLines;
+   uint64_t tempWarnings;
+   uint64_t gasWarnings;
+   uint64_t motionAlerts;
+   uint64_t fastPathAlarms;
+   uint64_t motionActive;
+   uint64_t gasDanger;
+   uint64_t boots;
+ };
+
+ #define LOG_COUNTER_FIELDS (sizeof(LogCounters) / sizeof(uint64_t))
+
+ struct ChunkResult {
+   LogCounters counts;
+   std::vector<LogEvent> events;
+   uint64_t tempHist[TEMP_HIST_BINS];
+   uint64_t gasHist[GAS_HIST_BINS];
+   int64_t firstTime;   // NO_TIME when the chunk has no timestamps
+   int64_t lastTime;
+   bool timeOfDay;      // timestamps carried no date
+ };
+
+ void parseChunk(const char* begin, const char* end, ChunkResult& result);
+ const char* logStateName(uint8_t state);
+ const char* logTriggerName(uint8_t bit);
+
+ #endif // LOG_PARSER_H
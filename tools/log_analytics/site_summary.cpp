@@ -0,0 +1,152 @@
+/*
+ * Site Summary implementation
+ * Chunks arrive in log order. Each chunk's events are replayed against the
+ * state carried over from the previous chunk, which fills in the "from"
+ * side of ARM/DISARM and resolves time-of-day stamps across midnight.
+ */
+
+ #include "site_summary.h"
+ #include <string.h>
+
+ SiteBuilder::SiteBuilder(const std::string& name)
+   : state(LOG_STATE_UNKNOWN), stateSince(NO_TIME), dayBase(0), lastAbsolute(NO_TIME) {
+   site.name = name;
+   memset(&site.counts, 0, sizeof(site.counts));
+   memset(site.tempHist, 0, sizeof(site.tempHist));
+   memset(site.gasHist, 0, sizeof(site.gasHist));
+   site.firstTime = NO_TIME;
+   site.lastTime = NO_TIME;
+   site.timeOfDay = false;
+   memset(site.timeInState, 0, sizeof(site.timeInState));
+   memset(site.edgeCount, 0, sizeof(site.edgeCount));
+   site.alarms = 0;
+   site.resyncs = 0;
+ }
+
+ /*
+  * Credit the time since stateSince to the current state
+  */
+ void SiteBuilder::closeInterval(int64_t time) {
+   if (time == NO_TIME) return;
+   if (state != LOG_STATE_UNKNOWN && stateSince != NO_TIME && time > stateSince) {
+     site.timeInState[state] += time - stateSince;
+   }
+   stateSince = time;
+ }
+
+ void SiteBuilder::enterState(int64_t time, uint8_t kind, uint8_t to) {
+   closeInterval(time);
+   if (state != LOG_STATE_UNKNOWN && state != to) {
+     site.edgeCount[state][to]++;
+     if (to == LOG_ALARM) site.alarms++;
+   }
+   TimelineEntry entry = {time, kind, state, to, 0};
+   site.timeline.push_back(entry);
+   state = to;
+ }
+
+ void SiteBuilder::addChunk(const ChunkResult& chunk) {
+   const uint64_t* counts = (const uint64_t*)&chunk.counts;
+   uint64_t* totals = (uint64_t*)&site.counts;
+   for (size_t i = 0; i < LOG_COUNTER_FIELDS; i++) totals[i] += counts[i];
+   for (int i = 0; i < TEMP_HIST_BINS; i++) site.tempHist[i] += chunk.tempHist[i];
+   for (int i = 0; i < GAS_HIST_BINS; i++) site.gasHist[i] += chunk.gasHist[i];
+
+   // Time-of-day chunks restart at day 0; move them past the previous chunk.
+   // A stamp more than 12h before the last one is taken as the next day, so
+   // a capture gap of more than 12h puts the chunk a whole number of days
+   // early; dated stamps have no such limit
+   int64_t offset = 0;
+   if (chunk.timeOfDay) {
+     site.timeOfDay = true;
+     offset = dayBase;
+     if (chunk.firstTime != NO_TIME && lastAbsolute != NO_TIME) {
+       while (chunk.firstTime + offset < lastAbsolute - MS_PER_DAY / 2) offset += MS_PER_DAY;
+     }
+     dayBase = offset;
+   }
+   if (chunk.firstTime != NO_TIME) {
+     if (site.firstTime == NO_TIME) site.firstTime = chunk.firstTime + offset;
+     site.lastTime = chunk.lastTime + offset;
+     lastAbsolute = site.lastTime;
+   }
+
+   for (size_t i = 0; i < chunk.events.size(); i++) {
+     const LogEvent& event = chunk.events[i];
+     int64_t time = event.time == NO_TIME ? NO_TIME : event.time + offset;
+
+     switch (event.kind) {
+       case EVENT_TRANSITION:
+         if (state != LOG_STATE_UNKNOWN && state != event.from) {
+           site.resyncs++;
+           enterState(time, TIMELINE_RESYNC, event.from);
+         } else if (state == LOG_STATE_UNKNOWN) {
+           state = event.from;
+           stateSince = time;
+         }
+         enterState(time, TIMELINE_TRANSITION, event.to);
+         break;
+
+       case EVENT_COMMAND:
+         if (state != event.to) enterState(time, TIMELINE_COMMAND, event.to);
+         break;
+
+       case EVENT_BOOT:
+         enterState(time, TIMELINE_BOOT, LOG_IDLE);
+         break;
+
+       case EVENT_OBSERVED:
+         if (state == LOG_STATE_UNKNOWN) {
+           state = event.to;
+           stateSince = time;
+         } else if (state != event.to) {
+           site.resyncs++;
+           enterState(time, TIMELINE_RESYNC, event.to);
+         }
+         break;
+
+       case EVENT_TRIGGERS:
+         if (!site.timeline.empty()) site.timeline.back().triggers = event.triggers;
+         break;
+     }
+   }
+ }
+
+ /*
+  * Close the state in progress at the last timestamp seen
+  */
+ SiteSummary& SiteBuilder::finish() {
+   closeInterval(site.lastTime);
+   return site;
+ }
+
+ uint64_t histogramTotal(const uint64_t* hist, int bins) {
+   uint64_t total = 0;
+   for (int i = 0; i < bins; i++) total += hist[i];
+   return total;
+ }
+
+ /*
+  * Bin index at or below which the given fraction of samples fall
+  */
+ int histogramPercentile(const uint64_t* hist, int bins, double fraction) {
+   uint64_t total = histogramTotal(hist, bins);
+   if (total == 0) return 0;
+   uint64_t target = (uint64_t)(fraction * (total - 1));
+   uint64_t seen = 0;
+   for (int i = 0; i < bins; i++) {
+     seen += hist[i];
+     if (seen > target) return i;
+   }
+   return bins - 1;
+ }
+
+ double histogramMean(const uint64_t* hist, int bins) {
+   uint64_t total = 0;
+   double sum = 0;
+   for (int i = 0; i < bins; i++) {
+     total += hist[i];
+     sum += (double)hist[i] * i;
+   }
+   return total ? sum / total : 0;
+ }
@@ -0,0 +1,68 @@
+/*
+ * Site Summary header declares the per-site aggregate built from parsed
+ * chunks: state timeline, time in state, alarm counts and sensor
+ * distributions
+ */
+
+ #ifndef SITE_SUMMARY_H
+ #define SITE_SUMMARY_H
+
+ #include "log_parser.h"
+ #include <string>
+
+ enum TimelineKind : uint8_t {
+   TIMELINE_TRANSITION,   // logged STATE: line
+   TIMELINE_COMMAND,      // ARM/DISARM
+   TIMELINE_BOOT,         // firmware restart, back to IDLE
+   TIMELINE_RESYNC        // a STATUS line disagreed with the tracked state (lines lost)
+ };
+
+ struct TimelineEntry {
+   int64_t time;       // NO_TIME if the log had no timestamp here
+   uint8_t kind;       // TimelineKind
+   uint8_t from;       // LogState, LOG_STATE_UNKNOWN before the first known state
+   uint8_t to;
+   uint8_t triggers;
+ };
+
+ struct SiteSummary {
+   std::string name;
+   LogCounters counts;
+   uint64_t tempHist[TEMP_HIST_BINS];
+   uint64_t gasHist[GAS_HIST_BINS];
+   int64_t firstTime;
+   int64_t lastTime;
+   bool timeOfDay;
+   uint64_t timeInState[LOG_STATE_COUNT];                 // ms
+   uint64_t edgeCount[LOG_STATE_COUNT][LOG_STATE_COUNT];
+   uint64_t alarms;                                       // entries into ALARM
+   uint64_t resyncs;
+   std::vector<TimelineEntry> timeline;
+ };
+
+ /*
+  * Folds a site's chunks, in log order, into a SiteSummary
+  */
+ class SiteBuilder {
+   public:
+     explicit SiteBuilder(const std::string& name);
+
+     void addChunk(const ChunkResult& chunk);
+     SiteSummary& finish();
+
+   private:
+     void enterState(int64_t time, uint8_t kind, uint8_t to);
+     void closeInterval(int64_t time);
+
+     SiteSummary site;
+     uint8_t state;
+     int64_t stateSince;
+     int64_t dayBase;       // added to time-of-day stamps
+     int64_t lastAbsolute;
+ };
+
+ uint64_t histogramTotal(const uint64_t* hist, int bins);
+ int histogramPercentile(const uint64_t* hist, int bins, double fraction);
+ double histogramMean(const uint64_t* hist, int bins);
+
+ #endif // SITE_SUMMARY_H
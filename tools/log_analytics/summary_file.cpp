@@ -0,0 +1,217 @@
+/*
+ * Summary File implementation
+ */
+
+ #include "summary_file.h"
+ #include <stdio.h>
+ #include <string.h>
+
+ // Append-only encoder
+ struct SummaryWriter {
+   std::vector<uint8_t> bytes;
+
+   void putVarint(uint64_t value) {
+     while (value >= 0x80) {
+       bytes.push_back((uint8_t)(value | 0x80));
+       value >>= 7;
+     }
+     bytes.push_back((uint8_t)value);
+   }
+
+   void putSigned(int64_t value) {
+     putVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+   }
+
+   void putBytes(const void* data, size_t size) {
+     const uint8_t* p = (const uint8_t*)data;
+     bytes.insert(bytes.end(), p, p + size);
+   }
+
+   // Non-zero bins only, as (gap from previous bin, count) pairs
+   void putHistogram(const uint64_t* hist, int bins) {
+     uint64_t used = 0;
+     for (int i = 0; i < bins; i++) used += hist[i] != 0;
+     putVarint(used);
+     int previous = -1;
+     for (int i = 0; i < bins; i++) {
+       if (hist[i] == 0) continue;
+       putVarint(i - previous - 1);
+       putVarint(hist[i]);
+       previous = i;
+     }
+   }
+ };
+
+ // Bounds-checked decoder; ok goes false on the first short or bad read
+ struct SummaryReader {
+   const uint8_t* p;
+   const uint8_t* end;
+   bool ok;
+
+   SummaryReader(const uint8_t* begin, const uint8_t* end) : p(begin), end(end), ok(true) {}
+
+   uint64_t getVarint() {
+     uint64_t value = 0;
+     for (int shift = 0; shift < 64; shift += 7) {
+       if (p >= end) break;
+       uint8_t byte = *p++;
+       value |= (uint64_t)(byte & 0x7F) << shift;
+       if (!(byte & 0x80)) return value;
+     }
+     ok = false;
+     return 0;
+   }
+
+   int64_t getSigned() {
+     uint64_t value = getVarint();
+     return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+   }
+
+   const uint8_t* getBytes(size_t size) {
+     if ((size_t)(end - p) < size) {
+       ok = false;
+       return NULL;
+     }
+     const uint8_t* data = p;
+     p += size;
+     return data;
+   }
+
+   void getHistogram(uint64_t* hist, int bins) {
+     memset(hist, 0, sizeof(uint64_t) * bins);
+     uint64_t used = getVarint();
+     int64_t bin = -1;
+     for (uint64_t i = 0; i < used && ok; i++) {
+       bin += getVarint() + 1;
+       uint64_t count = getVarint();
+       if (bin < 0 || bin >= bins) {
+         ok = false;
+         return;
+       }
+       hist[bin] = count;
+     }
+   }
+ };
+
+ bool writeSummaryFile(const char* path, const std::vector<SiteSummary>& sites) {
+   SummaryWriter out;
+   out.putBytes(SUMMARY_MAGIC, 4);
+   out.putVarint(SUMMARY_VERSION);
+   out.putVarint(sites.size());
+
+   for (size_t s = 0; s < sites.size(); s++) {
+     const SiteSummary& site = sites[s];
+     out.putVarint(site.name.size());
+     out.putBytes(site.name.data(), site.name.size());
+     out.putVarint(site.timeOfDay);
+     const uint64_t* counts = (const uint64_t*)&site.counts;
+     for (size_t i = 0; i < LOG_COUNTER_FIELDS; i++) out.putVarint(counts[i]);
+     out.putSigned(site.firstTime);
+     out.putSigned(site.lastTime);
+     for (int i = 0; i < LOG_STATE_COUNT; i++) out.putVarint(site.timeInState[i]);
+     for (int from = 0; from < LOG_STATE_COUNT; from++) {
+       for (int to = 0; to < LOG_STATE_COUNT; to++) out.putVarint(site.edgeCount[from][to]);
+     }
+     out.putVarint(site.alarms);
+     out.putVarint(site.resyncs);
+     out.putHistogram(site.tempHist, TEMP_HIST_BINS);
+     out.putHistogram(site.gasHist, GAS_HIST_BINS);
+     out.putVarint(site.timeline.size());
+   }
+
+   // Timeline columns
+   int64_t previous = 0;
+   for (size_t s = 0; s < sites.size(); s++) {
+     for (size_t i = 0; i < sites[s].timeline.size(); i++) {
+       int64_t time = sites[s].timeline[i].time;
+       if (time == NO_TIME) {
+         out.putVarint(0);
+         continue;
+       }
+       int64_t delta = time - previous;
+       out.putVarint(((((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63)) << 1) | 1);
+       previous = time;
+     }
+   }
+   for (int column = 0; column < 4; column++) {
+     for (size_t s = 0; s < sites.size(); s++) {
+       for (size_t i = 0; i < sites[s].timeline.size(); i++) {
+         const TimelineEntry& entry = sites[s].timeline[i];
+         const uint8_t values[4] = {entry.kind, entry.from, entry.to, entry.triggers};
+         out.bytes.push_back(values[column]);
+       }
+     }
+   }
+
+   FILE* file = fopen(path, "wb");
+   if (!file) return false;
+   bool written = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+   return fclose(file) == 0 && written;
+ }
+
+ bool readSummaryFile(const char* path, std::vector<SiteSummary>& sites) {
+   FILE* file = fopen(path, "rb");
+   if (!file) return false;
+   std::vector<uint8_t> bytes;
+   uint8_t buffer[65536];
+   size_t got;
+   while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.insert(bytes.end(), buffer, buffer + got);
+   fclose(file);
+
+   SummaryReader in(bytes.data(), bytes.data() + bytes.size());
+   const uint8_t* magic = in.getBytes(4);
+   if (!magic || memcmp(magic, SUMMARY_MAGIC, 4) != 0 || in.getVarint() != SUMMARY_VERSION) return false;
+
+   uint64_t siteCount = in.getVarint();
+   sites.clear();
+   for (uint64_t s = 0; s < siteCount && in.ok; s++) {
+     sites.push_back(SiteSummary());
+     SiteSummary& site = sites.back();
+     size_t nameLength = in.getVarint();
+     const uint8_t* name = in.getBytes(nameLength);
+     if (!name) return false;
+     site.name.assign((const char*)name, nameLength);
+     site.timeOfDay = in.getVarint() != 0;
+     uint64_t* counts = (uint64_t*)&site.counts;
+     for (size_t i = 0; i < LOG_COUNTER_FIELDS; i++) counts[i] = in.getVarint();
+     site.firstTime = in.getSigned();
+     site.lastTime = in.getSigned();
+     for (int i = 0; i < LOG_STATE_COUNT; i++) site.timeInState[i] = in.getVarint();
+     for (int from = 0; from < LOG_STATE_COUNT; from++) {
+       for (int to = 0; to < LOG_STATE_COUNT; to++) site.edgeCount[from][to] = in.getVarint();
+     }
+     site.alarms = in.getVarint();
+     site.resyncs = in.getVarint();
+     in.getHistogram(site.tempHist, TEMP_HIST_BINS);
+     in.getHistogram(site.gasHist, GAS_HIST_BINS);
+     uint64_t rows = in.getVarint();
+     if (rows > bytes.size()) return false;
+     site.timeline.resize(rows);
+   }
+
+   int64_t previous = 0;
+   for (size_t s = 0; s < sites.size() && in.ok; s++) {
+     for (size_t i = 0; i < sites[s].timeline.size(); i++) {
+       uint64_t value = in.getVarint();
+       if (!(value & 1)) {
+         sites[s].timeline[i].time = NO_TIME;
+         continue;
+       }
+       value >>= 1;
+       previous += (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+       sites[s].timeline[i].time = previous;
+     }
+   }
+   for (int column = 0; column < 4 && in.ok; column++) {
+     for (size_t s = 0; s < sites.size(); s++) {
+       const uint8_t* values = in.getBytes(sites[s].timeline.size());
+       if (!values) return false;
+       for (size_t i = 0; i < sites[s].timeline.size(); i++) {
+         TimelineEntry& entry = sites[s].timeline[i];
+         uint8_t* fields[4] = {&entry.kind, &entry.from, &entry.to, &entry.triggers};
+         *fields[column] = values[i];
+       }
+     }
+   }
+   return in.ok;
+ }
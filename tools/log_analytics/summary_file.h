@@ -0,0 +1,26 @@
+/*
+ * Summary File header declares the compact columnar summary format
+ *
+ * Layout (all integers LEB128 varints, signed ones zigzag-encoded):
+ *   "LSUM", version, site count
+ *   per site: name, time-of-day flag, counters, first/last time,
+ *             time in state, edge counts, alarms, resyncs,
+ *             sparse temperature and gas histograms, timeline row count
+ *   timeline columns for all sites, one after another:
+ *             time (delta from the previous row, low bit = has time),
+ *             kind, from, to, triggers (one byte per row each)
+ * Queries load this instead of re-parsing the logs.
+ */
+
+ #ifndef SUMMARY_FILE_H
+ #define SUMMARY_FILE_H
+
+ #include "site_summary.h"
+
+ #define SUMMARY_MAGIC "LSUM"
+ #define SUMMARY_VERSION 1
+
+ bool writeSummaryFile(const char* path, const std::vector<SiteSummary>& sites);
+ bool readSummaryFile(const char* path, std::vector<SiteSummary>& sites);
+
+ #endif // SUMMARY_FILE_H